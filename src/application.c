@@ -90,6 +90,8 @@ app_create(void *data)
 
     /* */
     eina_init();
+    /* Items, and their interned strings, are created by media library threads */
+    eina_threads_init();
     ecore_evas_init();
     emotion_init();
 
@@ -104,6 +106,12 @@ app_create(void *data)
     if (!app->p_ms)
         goto error;
 
+    /* Created first, so that the saved queue is restored without waiting for
+     * the media library */
+    app->p_ps = playback_service_create(app);
+    if (!app->p_ps)
+        goto error;
+
     /* Initialize media library first, but do not start it yet */
     app->p_mediaLibrary = media_library_create(app);
     if (!app->p_mediaLibrary)
@@ -114,11 +122,6 @@ app_create(void *data)
 
     media_storage_start_discovery(app->p_ms);
 
-    /* */
-    app->p_ps = playback_service_create(app);
-    if (!app->p_ps)
-        goto error;
-
     /* */
     app->p_intf = intf_create(app);
     if (!app->p_intf)
@@ -183,6 +186,7 @@ app_terminate(void *data)
 
     emotion_shutdown();
     ecore_evas_shutdown();
+    eina_threads_shutdown();
     eina_shutdown();
 }
 
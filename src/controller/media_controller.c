@@ -76,9 +76,10 @@ video_controller_create(application* p_app, list_view* p_list_view)
     if ( p_ctrl == NULL )
         return NULL;
     p_ctrl->pf_media_library_get_content = (pf_media_library_get_content_cb)&media_library_get_video_files;
-    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&media_item_copy;
+    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&library_item_hold;
     p_ctrl->pf_item_compare = (pf_item_compare_cb)&media_item_identical;
     p_ctrl->pf_accept_item = &video_controller_accept_item;
+    p_ctrl->sort.i_key = ML_SORT_TITLE;
     return p_ctrl;
 }
 
@@ -89,9 +90,10 @@ audio_controller_create(application* p_app, list_view* p_list_view)
     if ( p_ctrl == NULL )
         return NULL;
     p_ctrl->pf_media_library_get_content = (pf_media_library_get_content_cb)&media_library_get_audio_files;
-    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&media_item_copy;
+    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&library_item_hold;
     p_ctrl->pf_item_compare = (pf_item_compare_cb)&media_item_identical;
     p_ctrl->pf_accept_item = &audio_controller_accept_item;
+    p_ctrl->sort.i_key = ML_SORT_TITLE;
     return p_ctrl;
 }
 
@@ -102,9 +104,10 @@ artist_controller_create(application* p_app, list_view* p_list_view)
     if ( p_ctrl == NULL )
         return NULL;
     p_ctrl->pf_media_library_get_content = (pf_media_library_get_content_cb)&media_library_get_artists;
-    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&artist_item_copy;
+    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&library_item_hold;
     p_ctrl->pf_item_compare = (pf_item_compare_cb)&artist_item_identical;
     p_ctrl->pf_accept_item = &artist_controller_accept_item;
+    p_ctrl->sort.i_key = ML_SORT_TITLE;
     return p_ctrl;
 }
 
@@ -115,9 +118,10 @@ album_controller_create(application* p_app, list_view* p_list_view)
     if ( p_ctrl == NULL )
         return NULL;
     p_ctrl->pf_media_library_get_content = (pf_media_library_get_content_cb)&media_library_get_albums;
-    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&album_item_copy;
+    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&library_item_hold;
     p_ctrl->pf_item_compare = (pf_item_compare_cb)&album_item_identical;
     p_ctrl->pf_accept_item = &album_controller_accept_item;
+    p_ctrl->sort.i_key = ML_SORT_TITLE;
     return p_ctrl;
 }
 
@@ -128,8 +132,9 @@ genre_controller_create(application* p_app, list_view* p_list_view)
     if ( p_ctrl == NULL )
         return NULL;
     p_ctrl->pf_media_library_get_content = (pf_media_library_get_content_cb)&media_library_get_genres;
-    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&genre_item_copy;
+    p_ctrl->pf_item_duplicate = (pf_item_duplicate_cb)&library_item_hold;
     p_ctrl->pf_item_compare = (pf_item_compare_cb)&genre_item_identical;
     p_ctrl->pf_accept_item = &genre_controller_accept_item;
+    p_ctrl->sort.i_key = ML_SORT_TITLE;
     return p_ctrl;
 }
@@ -29,6 +29,7 @@
 
 #include "application.h"
 #include "media/library/media_library.hpp"
+#include "media/library/library_snapshot.h"
 #include "ui/views/video_view.h"
 #include "ui/interface.h"
 
@@ -36,13 +37,210 @@
 
 #include "media_library_controller_private.h"
 
+/* How far ahead of the insertion point a row delivered by the content query
+ * is looked for before being moved */
+#define RECONCILE_LOOKAHEAD 16
+
+/*
+ * Row index
+ * Rows are looked up by item type and id. Media items can be created before
+ * the media library assigns them an id, those are looked up by path, which is
+ * interned, so the path index compares pointers.
+ */
+typedef struct row_key
+{
+    int64_t             i_id;
+    library_item_type   i_type;
+} row_key;
+
+static unsigned int
+row_key_length(const void* p_key)
+{
+    (void)p_key;
+    return sizeof(row_key);
+}
+
+static int
+row_key_cmp(const void* p_key1, int i_len1, const void* p_key2, int i_len2)
+{
+    (void)i_len1; (void)i_len2;
+    const row_key* p_left = p_key1;
+    const row_key* p_right = p_key2;
+    if (p_left->i_id != p_right->i_id)
+        return p_left->i_id < p_right->i_id ? -1 : 1;
+    return (int)p_left->i_type - (int)p_right->i_type;
+}
+
+static int
+row_key_hash(const void* p_key, int i_len)
+{
+    (void)i_len;
+    const row_key* p_row_key = p_key;
+    unsigned long long i_id = (unsigned long long)p_row_key->i_id;
+    return eina_hash_int64(&i_id, sizeof(i_id)) ^ (int)p_row_key->i_type;
+}
+
+static const char*
+row_path(const library_item* p_item)
+{
+    if (p_item->i_library_item_type != LIBRARY_ITEM_MEDIA)
+        return NULL;
+    return ((const media_item*)p_item)->psz_path;
+}
+
+static void
+media_library_controller_index_add(media_library_controller* ctrl, Eina_List* p_node)
+{
+    const library_item* p_item = ctrl->p_list_view->pf_get_item( eina_list_data_get( p_node ) );
+    row_key key = { library_item_get_id( p_item ), p_item->i_library_item_type };
+    const char* psz_path = row_path( p_item );
+
+    if (key.i_id != 0)
+        eina_hash_set( ctrl->p_rows_by_id, &key, p_node );
+    if (psz_path != NULL)
+        eina_hash_set( ctrl->p_rows_by_path, psz_path, p_node );
+}
+
+static void
+media_library_controller_index_del(media_library_controller* ctrl, Eina_List* p_node)
+{
+    const library_item* p_item = ctrl->p_list_view->pf_get_item( eina_list_data_get( p_node ) );
+    row_key key = { library_item_get_id( p_item ), p_item->i_library_item_type };
+    const char* psz_path = row_path( p_item );
+
+    /* Only drop the entries that still point to this row */
+    if (key.i_id != 0 && eina_hash_find( ctrl->p_rows_by_id, &key ) == p_node)
+        eina_hash_del_by_key( ctrl->p_rows_by_id, &key );
+    if (psz_path != NULL && eina_hash_find( ctrl->p_rows_by_path, psz_path ) == p_node)
+        eina_hash_del_by_key( ctrl->p_rows_by_path, psz_path );
+}
+
+/* Returns the node of the row displaying p_item, following the same rules as
+ * the pf_item_compare callbacks: ids are compared when both items have one,
+ * paths otherwise */
+static Eina_List*
+media_library_controller_index_find(media_library_controller* ctrl, const library_item* p_item)
+{
+    row_key key = { library_item_get_id( p_item ), p_item->i_library_item_type };
+    const char* psz_path = row_path( p_item );
+    Eina_List* p_node;
+
+    if (key.i_id != 0)
+    {
+        p_node = eina_hash_find( ctrl->p_rows_by_id, &key );
+        if (p_node != NULL)
+            return p_node;
+    }
+    if (psz_path == NULL)
+        return NULL;
+    p_node = eina_hash_find( ctrl->p_rows_by_path, psz_path );
+    if (p_node == NULL || key.i_id == 0)
+        return p_node;
+    /* A row that already has an id only matches by id */
+    const library_item* p_row_item = ctrl->p_list_view->pf_get_item( eina_list_data_get( p_node ) );
+    return library_item_get_id( p_row_item ) == 0 ? p_node : NULL;
+}
+
 static void
-media_library_controller_add_item(media_library_controller* ctrl, media_item* p_item)
+media_library_controller_index_clear(media_library_controller* ctrl)
 {
-    void* p_view_item = ctrl->p_list_view->pf_append_item( ctrl->p_list_view->p_sys, p_item );
+    eina_hash_free_buckets( ctrl->p_rows_by_id );
+    eina_hash_free_buckets( ctrl->p_rows_by_path );
+}
+
+/* Inserts a row before p_before, or appends it if p_before is NULL */
+static bool
+media_library_controller_insert_row(media_library_controller* ctrl, void* p_item, Eina_List* p_before)
+{
+    list_view_item* p_before_item = p_before != NULL ? eina_list_data_get( p_before ) : NULL;
+    void* p_view_item = ctrl->p_list_view->pf_insert_item( ctrl->p_list_view->p_sys, p_item, p_before_item );
     if (p_view_item == NULL)
+        return false;
+    Eina_List* p_node;
+    if (p_before == NULL)
+    {
+        ctrl->p_content = eina_list_append( ctrl->p_content, p_view_item );
+        p_node = eina_list_last( ctrl->p_content );
+    }
+    else
+    {
+        ctrl->p_content = eina_list_prepend_relative_list( ctrl->p_content, p_view_item, p_before );
+        p_node = eina_list_prev( p_before );
+    }
+    media_library_controller_index_add( ctrl, p_node );
+    return true;
+}
+
+/* Replaces the item displayed by a row, keeping the index up to date */
+static void
+media_library_controller_set_row_item(media_library_controller* ctrl, Eina_List* p_node, void* p_item)
+{
+    media_library_controller_index_del( ctrl, p_node );
+    ctrl->p_list_view->pf_set_item( eina_list_data_get( p_node ), p_item );
+    media_library_controller_index_add( ctrl, p_node );
+}
+
+/* Duplicates an item that replaces the one of an existing row. Such an item
+ * comes from a result set the other rows don't use, which it would otherwise
+ * keep alive */
+static void*
+media_library_controller_duplicate_update(media_library_controller* ctrl, const library_item* p_library_item)
+{
+    library_item* p_new_library_item = ctrl->pf_item_duplicate( p_library_item );
+    if ( p_new_library_item != NULL && p_new_library_item->i_library_item_type == LIBRARY_ITEM_MEDIA )
+        p_new_library_item = (library_item*)media_item_detach( (media_item*)p_new_library_item );
+    return p_new_library_item;
+}
+
+/* Only updates the row when the item it displays changed */
+static void
+media_library_controller_update_row(media_library_controller* ctrl, Eina_List* p_node, const library_item* p_library_item)
+{
+    const library_item* p_row_item = ctrl->p_list_view->pf_get_item( eina_list_data_get( p_node ) );
+    if ( library_item_equal( p_row_item, p_library_item ) == true )
         return;
-    ctrl->p_content = eina_list_append(ctrl->p_content, p_view_item);
+    void* p_new_library_item = media_library_controller_duplicate_update( ctrl, p_library_item );
+    if ( p_new_library_item != NULL )
+        media_library_controller_set_row_item( ctrl, p_node, p_new_library_item );
+}
+
+static void
+media_library_controller_free_index(media_library_controller* ctrl)
+{
+    if (ctrl->p_rows_by_id != NULL)
+        eina_hash_free( ctrl->p_rows_by_id );
+    if (ctrl->p_rows_by_path != NULL)
+        eina_hash_free( ctrl->p_rows_by_path );
+    if (ctrl->p_pending_rows != NULL)
+        eina_hash_free( ctrl->p_pending_rows );
+}
+
+static bool
+media_library_controller_is_pending(media_library_controller* ctrl, Eina_List* p_node)
+{
+    return eina_hash_find( ctrl->p_pending_rows, &p_node ) != NULL;
+}
+
+static void
+media_library_controller_remove_row(media_library_controller* ctrl, Eina_List* p_node)
+{
+    void* p_view_item = eina_list_data_get( p_node );
+    if ( p_node == ctrl->p_query_next )
+        ctrl->p_query_next = eina_list_next( p_node );
+    eina_hash_del_by_key( ctrl->p_pending_rows, &p_node );
+    media_library_controller_index_del( ctrl, p_node );
+    ctrl->p_content = eina_list_remove_list( ctrl->p_content, p_node );
+    ctrl->p_list_view->pf_remove_item( ctrl->p_list_view->p_sys, p_view_item );
+}
+
+/* Tells whether an item the list doesn't display yet belongs to it */
+static bool
+media_library_controller_filter_item(media_library_controller* ctrl, const library_item* p_library_item)
+{
+    if ( ctrl->b_filtered == false )
+        return true;
+    return ctrl->pf_filter_item != NULL &&
+           ctrl->pf_filter_item( p_library_item, ctrl->p_filter_data ) == true;
 }
 
 bool
@@ -51,55 +249,209 @@ media_library_controller_file_update( media_library_controller* ctrl, const libr
     if ( ctrl->pf_accept_item( p_library_item ) == false )
         return false;
 
-    void* p_new_library_item = ctrl->pf_item_duplicate( p_library_item );
-    if (p_new_library_item == NULL)
+    Eina_List* p_node = media_library_controller_index_find( ctrl, p_library_item );
+    if ( p_node == NULL && media_library_controller_filter_item( ctrl, p_library_item ) == false )
         return true;
 
-    if ( ctrl->p_content != NULL )
-    {
-        Eina_List* it;
-        void* p_item;
-        EINA_LIST_FOREACH( ctrl->p_content, it, p_item )
-        {
-            const void* p_media_item = ctrl->p_list_view->pf_get_item(p_item);
+    void* p_new_library_item = media_library_controller_duplicate_update( ctrl, p_library_item );
+    if (p_new_library_item == NULL)
+        return true;
 
-            if ( ctrl->pf_item_compare( p_media_item, p_new_library_item) )
-            {
-                ctrl->p_list_view->pf_set_item(p_item, p_new_library_item);
-                return true;
-            }
-        }
-    }
-    media_library_controller_add_item( ctrl, p_new_library_item );
+    if ( p_node != NULL )
+        media_library_controller_set_row_item( ctrl, p_node, p_new_library_item );
+    else if ( media_library_controller_insert_row( ctrl, p_new_library_item, NULL ) == false )
+        library_item_destroy( p_new_library_item );
     return true;
 }
 
-static bool
-media_library_controller_file_updated_cb(void* p_data, const library_item* p_new_media_item, bool b_added )
+static void
+media_library_controller_files_updated_cb(void* p_data, const library_item* const* pp_items, unsigned int i_nb_items, bool b_added )
 {
     (void)b_added;
     media_library_controller* ctrl = (media_library_controller*)p_data;
-    return media_library_controller_file_update(ctrl, p_new_media_item);
+    for ( unsigned int i = 0; i < i_nb_items; ++i )
+        media_library_controller_file_update(ctrl, pp_items[i]);
 }
 
-/* Called by the Media Library with updated video list
+/* Removes the rows displaying the removed items, if any.
  * Guaranteed to be called from the main loop
  */
-void
-media_library_controller_content_update_cb(Eina_List* p_content, void* p_data)
+static void
+media_library_controller_items_removed_cb(void* p_data, library_item_type i_type, const int64_t* pi_ids, unsigned int i_nb_ids)
 {
-    if (p_content == NULL)
-        return;
     media_library_controller* ctrl = (media_library_controller*)p_data;
+
+    for ( unsigned int i = 0; i < i_nb_ids; ++i )
+    {
+        row_key key = { pi_ids[i], i_type };
+        Eina_List* p_node = eina_hash_find( ctrl->p_rows_by_id, &key );
+        if ( p_node != NULL )
+            media_library_controller_remove_row( ctrl, p_node );
+    }
+}
+
+/* Marks all the rows as pending, the content query will confirm the ones that
+ * are still part of the list */
+static void
+media_library_controller_begin_reconcile(media_library_controller* ctrl)
+{
+    Eina_List* it;
+
+    eina_hash_free_buckets( ctrl->p_pending_rows );
+    for ( it = ctrl->p_content; it != NULL; it = eina_list_next( it ) )
+        eina_hash_add( ctrl->p_pending_rows, &it, it );
+    ctrl->p_query_next = ctrl->p_content;
+}
+
+/* Removes the rows the content query didn't deliver */
+static void
+media_library_controller_end_reconcile(media_library_controller* ctrl)
+{
+    Eina_List* it = ctrl->p_content;
+
+    while ( it != NULL && eina_hash_population( ctrl->p_pending_rows ) > 0 )
+    {
+        Eina_List* it_next = eina_list_next( it );
+        if ( media_library_controller_is_pending( ctrl, it ) == true )
+            media_library_controller_remove_row( ctrl, it );
+        it = it_next;
+    }
+    ctrl->p_query_next = NULL;
+}
+
+static void
+media_library_controller_load_snapshot(media_library_controller* ctrl)
+{
+    library_item* p_item;
+    Eina_List* p_items = library_snapshot_load( ctrl->psz_snapshot, &ctrl->sort );
+
+    EINA_LIST_FREE( p_items, p_item )
+    {
+        if ( ctrl->pf_accept_item( p_item ) == false ||
+             media_library_controller_insert_row( ctrl, p_item, NULL ) == false )
+            library_item_destroy( p_item );
+    }
+}
+
+static void
+media_library_controller_save_snapshot(media_library_controller* ctrl)
+{
+    const library_item* pp_items[LIBRARY_SNAPSHOT_MAX_ITEMS];
+    unsigned int i_nb_items = 0;
     Eina_List* it;
+    void* p_view_item;
+
+    EINA_LIST_FOREACH( ctrl->p_content, it, p_view_item )
+    {
+        if ( i_nb_items == LIBRARY_SNAPSHOT_MAX_ITEMS )
+            break;
+        pp_items[i_nb_items++] = ctrl->p_list_view->pf_get_item( p_view_item );
+    }
+    library_snapshot_save( ctrl->psz_snapshot, &ctrl->sort, pp_items, i_nb_items );
+}
+
+/* Handles an item delivered by the content query.
+ * The rows displayed before the query started are matched by id, and only
+ * updated if their item changed. A row found a few rows ahead of the insertion
+ * point is kept where it is, the rows in between are left pending. Rows found
+ * further away are moved, new items are inserted at the insertion point.
+ */
+static void
+media_library_controller_query_item(media_library_controller* ctrl, const library_item* p_library_item)
+{
+    if ( ctrl->pf_accept_item( p_library_item ) == false )
+        return;
+
+    Eina_List* p_node = media_library_controller_index_find( ctrl, p_library_item );
+    if ( p_node != NULL && media_library_controller_is_pending( ctrl, p_node ) == true )
+    {
+        Eina_List* it = ctrl->p_query_next;
+        for ( unsigned int i = 0; it != NULL && it != p_node && i < RECONCILE_LOOKAHEAD; ++i )
+            it = eina_list_next( it );
+        if ( it == p_node )
+        {
+            eina_hash_del_by_key( ctrl->p_pending_rows, &p_node );
+            ctrl->p_query_next = eina_list_next( p_node );
+            media_library_controller_update_row( ctrl, p_node, p_library_item );
+            return;
+        }
+        /* Genlist items can't be moved, the row is created again */
+        media_library_controller_remove_row( ctrl, p_node );
+        p_node = NULL;
+    }
+    if ( p_node != NULL )
+    {
+        media_library_controller_update_row( ctrl, p_node, p_library_item );
+        return;
+    }
+    void* p_new_library_item = ctrl->pf_item_duplicate( p_library_item );
+    if ( p_new_library_item != NULL &&
+         media_library_controller_insert_row( ctrl, p_new_library_item, ctrl->p_query_next ) == false )
+        library_item_destroy( p_new_library_item );
+}
+
+/* Called by the Media Library with a page of the requested content.
+ * Pages are appended as they come, so the first screenful is displayed as soon
+ * as it is available.
+ * Guaranteed to be called from the main loop
+ */
+void
+media_library_controller_content_update_cb(Eina_List* p_content, bool b_last, void* p_data)
+{
+    media_library_controller* ctrl = (media_library_controller*)p_data;
     void* p_item;
 
-    EINA_LIST_FOREACH( p_content, it, p_item )
+    /* The query handle isn't valid anymore after its last page */
+    if (b_last == true)
+        ctrl->p_query = NULL;
+
+    /* The rows hold their own reference on the items they display */
+    EINA_LIST_FREE( p_content, p_item )
     {
-        media_library_controller_file_update(ctrl, p_item);
+        media_library_controller_query_item(ctrl, p_item);
+        library_item_destroy(p_item);
+    }
+
+    if (b_last == true)
+    {
+        media_library_controller_end_reconcile(ctrl);
+        if (ctrl->psz_snapshot != NULL)
+            media_library_controller_save_snapshot(ctrl);
+    }
+}
+
+static void
+media_library_controller_cancel_refresh(media_library_controller* ctrl)
+{
+    if (ctrl->p_refresh_job != NULL)
+    {
+        ecore_job_del(ctrl->p_refresh_job);
+        ctrl->p_refresh_job = NULL;
+    }
+    if (ctrl->p_refresh_timer != NULL)
+    {
+        ecore_timer_del(ctrl->p_refresh_timer);
+        ctrl->p_refresh_timer = NULL;
     }
 }
 
+/*
+ * Naviframes hide the items below their top one, so a list is on screen when
+ * none of the objects containing it is hidden. Lists the user navigated away
+ * from are still refreshed, after the ones being looked at.
+ */
+static media_library_query_priority
+media_library_controller_query_priority(media_library_controller* ctrl)
+{
+    Evas_Object* p_obj = ctrl->p_list_view->pf_get_widget(ctrl->p_list_view->p_sys);
+    for (; p_obj != NULL; p_obj = evas_object_smart_parent_get(p_obj))
+    {
+        if (evas_object_visible_get(p_obj) == EINA_FALSE)
+            return ML_QUERY_PRIORITY_SPECULATIVE;
+    }
+    return ML_QUERY_PRIORITY_VISIBLE;
+}
+
 /*
  * Called when media library signals a content change (currently, only after reload)
  * Guaranteed to be called from the main loop
@@ -109,21 +461,89 @@ media_library_controller_content_changed_cb(void* p_data)
 {
     media_library_controller* ctrl = (media_library_controller*)p_data;
 
-    // Discard previous content if any, and ask ML for the new content
-    if (ctrl->p_content != NULL)
+    /* This is the refresh they were waiting for */
+    media_library_controller_cancel_refresh(ctrl);
+    // Ask ML for the new content. The current rows, including the snapshot
+    // ones, are kept and reconciled with the new content as it comes.
+    media_library_query_cancel(ctrl->p_query);
+    if (ctrl->b_reset_content == true && ctrl->p_content != NULL)
     {
+        media_library_controller_index_clear(ctrl);
         eina_list_free(ctrl->p_content);
         ctrl->p_list_view->pf_clear(ctrl->p_list_view->p_sys);
         ctrl->p_content = NULL;
     }
+    ctrl->b_reset_content = false;
+    media_library_controller_begin_reconcile(ctrl);
     media_library* p_ml = (media_library*)application_get_media_library( ctrl->p_app );
-    ctrl->pf_media_library_get_content(p_ml, &media_library_controller_content_update_cb, ctrl->p_user_data);
+    ctrl->p_query = ctrl->pf_media_library_get_content(p_ml, &ctrl->sort,
+            media_library_controller_query_priority(ctrl), &media_library_controller_content_update_cb, ctrl->p_user_data);
+    /* No content, nothing will confirm the current rows */
+    if (ctrl->p_query == NULL)
+        media_library_controller_end_reconcile(ctrl);
+}
+
+static void
+media_library_controller_refresh_job_cb(void* p_data)
+{
+    media_library_controller* ctrl = (media_library_controller*)p_data;
+    ctrl->p_refresh_job = NULL;
+    media_library_controller_content_changed_cb(ctrl);
+}
+
+static Eina_Bool
+media_library_controller_refresh_timer_cb(void* p_data)
+{
+    media_library_controller* ctrl = (media_library_controller*)p_data;
+    ctrl->p_refresh_timer = NULL;
+    media_library_controller_content_changed_cb(ctrl);
+    return ECORE_CALLBACK_CANCEL;
 }
 
 void
 media_library_controller_refresh(media_library_controller* p_ctrl)
 {
-    ecore_main_loop_thread_safe_call_async(&media_library_controller_content_changed_cb, p_ctrl);
+    /* Display the snapshot right away, the first query can take a while */
+    if (p_ctrl->psz_snapshot != NULL && p_ctrl->b_snapshot_loaded == false)
+    {
+        p_ctrl->b_snapshot_loaded = true;
+        if (p_ctrl->p_content == NULL)
+            media_library_controller_load_snapshot(p_ctrl);
+    }
+    /* The refreshes requested until the next main loop iteration share a query */
+    if (p_ctrl->p_refresh_job == NULL)
+        p_ctrl->p_refresh_job = ecore_job_add(&media_library_controller_refresh_job_cb, p_ctrl);
+}
+
+void
+media_library_controller_refresh_delayed(media_library_controller* p_ctrl, double f_delay)
+{
+    if (p_ctrl->p_refresh_timer != NULL)
+        ecore_timer_del(p_ctrl->p_refresh_timer);
+    p_ctrl->p_refresh_timer = ecore_timer_add(f_delay, &media_library_controller_refresh_timer_cb, p_ctrl);
+}
+
+void
+media_library_controller_set_sort(media_library_controller* p_ctrl, media_library_sort_key i_key, bool b_descending)
+{
+    if (p_ctrl->sort.i_key != i_key || p_ctrl->sort.b_descending != b_descending)
+        p_ctrl->b_reset_content = true;
+    p_ctrl->sort.i_key = i_key;
+    p_ctrl->sort.b_descending = b_descending;
+}
+
+void
+media_library_controller_set_snapshot(media_library_controller* p_ctrl, const char* psz_name)
+{
+    p_ctrl->psz_snapshot = psz_name;
+}
+
+void
+media_library_controller_set_filter(media_library_controller* p_ctrl, pf_filter_item_cb pf_filter, void* p_user_data)
+{
+    p_ctrl->b_filtered = true;
+    p_ctrl->pf_filter_item = pf_filter;
+    p_ctrl->p_filter_data = p_user_data;
 }
 
 void
@@ -143,20 +563,35 @@ media_library_controller_create(application* p_app, list_view* p_list_view )
    ctrl->p_list_view = p_list_view;
    /* Default the user data to ourselves. This is when the callbacks are our defaults ones */
    ctrl->p_user_data = ctrl;
+   ctrl->p_rows_by_id = eina_hash_new(&row_key_length, &row_key_cmp, &row_key_hash, NULL, 8);
+   ctrl->p_rows_by_path = eina_hash_stringshared_new(NULL);
+   ctrl->p_pending_rows = eina_hash_pointer_new(NULL);
+   if ( ctrl->p_rows_by_id == NULL || ctrl->p_rows_by_path == NULL || ctrl->p_pending_rows == NULL )
+   {
+       media_library_controller_free_index( ctrl );
+       free(ctrl);
+       return NULL;
+   }
 
    /* Populate it */
    media_library* p_ml = (media_library*)application_get_media_library(p_app);
    media_library_register_on_change(p_ml, media_library_controller_content_changed_cb, ctrl);
-   media_library_register_item_updated(p_ml, media_library_controller_file_updated_cb, ctrl);
+   media_library_register_items_updated(p_ml, media_library_controller_files_updated_cb, ctrl);
+   media_library_register_items_removed(p_ml, media_library_controller_items_removed_cb, ctrl);
    return ctrl;
 }
 
 void
 media_library_controller_destroy(media_library_controller *ctrl)
 {
+    /* Don't let a pending query or refresh call us back once we're gone */
+    media_library_query_cancel(ctrl->p_query);
+    media_library_controller_cancel_refresh(ctrl);
     eina_list_free(ctrl->p_content);
+    media_library_controller_free_index(ctrl);
     media_library* p_ml = (media_library*)application_get_media_library(ctrl->p_app);
     media_library_unregister_on_change(p_ml, &media_library_controller_content_changed_cb, ctrl);
-    media_library_unregister_item_updated(p_ml, &media_library_controller_file_updated_cb, ctrl);
+    media_library_unregister_items_updated(p_ml, &media_library_controller_files_updated_cb, ctrl);
+    media_library_unregister_items_removed(p_ml, &media_library_controller_items_removed_cb, ctrl);
     free(ctrl);
 }
@@ -39,7 +39,38 @@ media_library_controller_destroy(media_library_controller *);
 void
 media_library_controller_refresh( media_library_controller* p_ctrl );
 
+/*
+ * Refreshes the list once no refresh has been requested for f_delay seconds,
+ * so that a query isn't started for each character of a search pattern.
+ */
+void
+media_library_controller_refresh_delayed( media_library_controller* p_ctrl, double f_delay );
+
+/* Sets the order of the content. It applies from the next refresh */
+void
+media_library_controller_set_sort( media_library_controller* p_ctrl, media_library_sort_key i_key, bool b_descending );
+
+/*
+ * Saves the first items of the list under psz_name once they have been
+ * fetched, and displays them on the next start until the media library
+ * provides the actual content.
+ * Only meant for lists that don't depend on anything but the sort.
+ */
+void
+media_library_controller_set_snapshot( media_library_controller* p_ctrl, const char* psz_name );
+
+/*
+ * Marks the list as displaying a subset of the items of its type, such as the
+ * songs of an album, or search results.
+ * The media library reports updated items regardless of the lists they belong
+ * to: the rows already displayed are still updated, but other items are only
+ * appended when pf_filter accepts them. When pf_filter is NULL, the list only
+ * gets new items from its content query.
+ */
+void
+media_library_controller_set_filter( media_library_controller* p_ctrl, bool (*pf_filter)(const library_item* p_item, void* p_user_data), void* p_user_data );
+
 void
-media_library_controller_set_content_callback(media_library_controller* p_ctrl, void(*cb)(media_library* p_ml, media_library_list_cb cb, void* p_user_data), void* p_user_data);
+media_library_controller_set_content_callback(media_library_controller* p_ctrl, media_library_query*(*cb)(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data), void* p_user_data);
 
 #endif /* MEDIA_LIBRARY_CONTROLLER_H_ */
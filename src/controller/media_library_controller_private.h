@@ -30,15 +30,11 @@
 #include "application.h"
 #include "media/library/library_item.h"
 
-struct library_item
-{
-    LIBRARY_ITEM_COMMON
-};
-
-typedef void                (*pf_media_library_get_content_cb)( media_library* p_ml, media_library_list_cb cb, void* p_user_data );
+typedef media_library_query* (*pf_media_library_get_content_cb)( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 typedef bool                (*pf_item_compare_cb)(const void* p_left, const void* p_right);
 typedef void*               (*pf_item_duplicate_cb)( const void* p_item );
 typedef bool                (*pf_accept_item_cb)( const library_item* p_item );
+typedef bool                (*pf_filter_item_cb)( const library_item* p_item, void* p_user_data );
 
 struct media_library_controller
 {
@@ -49,6 +45,34 @@ struct media_library_controller
     list_view*      p_list_view;
     Eina_List*      p_content;
     void*           p_user_data;
+    /* Content query in progress, if any */
+    media_library_query* p_query;
+    /* Pending refresh, if any */
+    Ecore_Job*      p_refresh_job;
+    Ecore_Timer*    p_refresh_timer;
+    media_library_sort sort;
+    /* Name of the snapshot of this list, or NULL if it doesn't have one */
+    const char*     psz_snapshot;
+    bool            b_snapshot_loaded;
+    /* Nodes of p_content displayed before the content query started, and
+     * that it hasn't delivered yet */
+    Eina_Hash*      p_pending_rows;
+    /* Node before which the next row delivered by the query is inserted, or
+     * NULL to append it */
+    Eina_List*      p_query_next;
+    /* Rebuild the list on the next query instead of reconciling it, when
+     * most rows would move anyway */
+    bool            b_reset_content;
+    /* Nodes of p_content, indexed by item type and id, and by path for
+     * media items */
+    Eina_Hash*      p_rows_by_id;
+    Eina_Hash*      p_rows_by_path;
+    /* The list only displays some of the items pf_accept_item accepts. Items
+     * it doesn't display yet are only appended when pf_filter_item accepts
+     * them, if set */
+    bool            b_filtered;
+    pf_filter_item_cb pf_filter_item;
+    void*           p_filter_data;
 
     /**
      * Callbacks & settings
@@ -27,6 +27,8 @@
 #include "common.h"
 #include "album_item.h"
 
+#include <Eina.h>
+
 album_item*
 album_item_create(const char* psz_name)
 {
@@ -34,7 +36,8 @@ album_item_create(const char* psz_name)
     if (p_item == NULL)
         return NULL;
     p_item->i_library_item_type = LIBRARY_ITEM_ALBUM;
-    p_item->psz_name = strdup(psz_name);
+    p_item->i_refs = 1;
+    p_item->psz_name = eina_stringshare_add(psz_name);
     if (p_item->psz_name == NULL)
     {
         free(p_item);
@@ -52,9 +55,9 @@ album_item_copy(const album_item* p_item)
     p_new_item->i_id = p_item->i_id;
     if (p_item->psz_summary != NULL)
         p_new_item->psz_summary = strdup(p_item->psz_summary);
-    if (p_item->psz_artwork != NULL)
-        p_new_item->psz_artwork = strdup(p_item->psz_artwork);
+    p_new_item->psz_artwork = eina_stringshare_ref(p_item->psz_artwork);
     p_new_item->i_nb_tracks = p_item->i_nb_tracks;
+    p_new_item->i_duration = p_item->i_duration;
     p_new_item->i_release_date = p_item->i_release_date;
     return p_new_item;
 }
@@ -68,10 +71,10 @@ album_item_identical(const album_item* p_left, const album_item* p_right)
 void
 album_item_destroy(album_item* p_item)
 {
-    if (p_item == NULL)
+    if (p_item == NULL || !library_item_unref((library_item*)p_item))
         return;
-    free(p_item->psz_artwork);
+    eina_stringshare_del(p_item->psz_artwork);
     free(p_item->psz_summary);
-    free(p_item->psz_name);
+    eina_stringshare_del(p_item->psz_name);
     free(p_item);
 }
@@ -37,11 +37,12 @@ typedef struct album_item {
     LIBRARY_ITEM_COMMON
 
     unsigned int i_id;
-    char* psz_name;
+    const char* psz_name;           /* Interned */
     char* psz_summary;
     time_t i_release_date;
-    char* psz_artwork;
+    const char* psz_artwork;        /* Interned */
     uint32_t i_nb_tracks;
+    int64_t i_duration;             /* in ms */
 } album_item;
 
 album_item*
@@ -28,6 +28,8 @@
 #include "artist_item.h"
 #include "media/library/media_library.hpp"
 
+#include <Eina.h>
+
 artist_item*
 artist_item_create(const char* psz_name)
 {
@@ -35,10 +37,11 @@ artist_item_create(const char* psz_name)
     if (p_item == NULL)
         return NULL;
     p_item->i_library_item_type = LIBRARY_ITEM_ARTIST;
+    p_item->i_refs = 1;
     p_item->i_nb_albums = 0;
     if (psz_name != NULL && *psz_name != 0)
     {
-        p_item->psz_name = strdup(psz_name);
+        p_item->psz_name = eina_stringshare_add(psz_name);
         if (p_item->psz_name == NULL)
         {
             free(p_item);
@@ -51,10 +54,10 @@ artist_item_create(const char* psz_name)
 void
 artist_item_destroy(artist_item* p_item)
 {
-    if (p_item == NULL)
+    if (p_item == NULL || !library_item_unref((library_item*)p_item))
         return;
-    free(p_item->psz_artwork);
-    free(p_item->psz_name);
+    eina_stringshare_del(p_item->psz_artwork);
+    eina_stringshare_del(p_item->psz_name);
     free(p_item);
 }
 
@@ -65,8 +68,7 @@ artist_item_copy(const artist_item* p_item )
     if (p_new == NULL)
         return NULL;
     p_new->i_id = p_item->i_id;
-    if (p_item->psz_artwork != NULL)
-        p_new->psz_artwork = strdup(p_item->psz_artwork);
+    p_new->psz_artwork = eina_stringshare_ref(p_item->psz_artwork);
     p_new->i_nb_albums = p_item->i_nb_albums;
     return p_new;
 }
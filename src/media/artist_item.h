@@ -37,8 +37,8 @@ typedef struct artist_item
 {
     LIBRARY_ITEM_COMMON
 
-    char* psz_name;
-    char* psz_artwork;
+    const char* psz_name;           /* Interned */
+    const char* psz_artwork;        /* Interned */
     uint32_t i_nb_albums;
     uint32_t i_id;
 } artist_item;
@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+#include "artwork.h"
+
+static const struct
+{
+    const char* psz_suffix;
+    int i_size;
+} artwork_variants[ARTWORK_VARIANT_COUNT] = {
+    [ARTWORK_ICON] = { ".icon.jpg", 96 },
+    [ARTWORK_COVER] = { ".cover.jpg", 360 },
+    [ARTWORK_FULLSCREEN] = { ".full.jpg", 720 },
+};
+
+int
+artwork_variant_size( artwork_variant i_variant )
+{
+    return artwork_variants[i_variant].i_size;
+}
+
+const char*
+artwork_variant_suffix( artwork_variant i_variant )
+{
+    return artwork_variants[i_variant].psz_suffix;
+}
+
+const char*
+artwork_variant_path( const char* psz_icon, artwork_variant i_variant, char* psz_buf, size_t i_size )
+{
+    if ( psz_icon == NULL || i_variant == ARTWORK_ICON )
+        return psz_icon;
+    const char* psz_suffix = artwork_variants[ARTWORK_ICON].psz_suffix;
+    size_t i_len = strlen( psz_icon );
+    size_t i_suffix_len = strlen( psz_suffix );
+    if ( i_len < i_suffix_len || strcmp( psz_icon + i_len - i_suffix_len, psz_suffix ) != 0 )
+        return psz_icon;
+    int i_res = snprintf( psz_buf, i_size, "%.*s%s", (int)( i_len - i_suffix_len ), psz_icon,
+                          artwork_variants[i_variant].psz_suffix );
+    if ( i_res < 0 || (size_t)i_res >= i_size )
+        return psz_icon;
+    return psz_buf;
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#ifndef ARTWORK_H_
+# define ARTWORK_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Snapshots & artworks are scaled at scan time to the sizes they are displayed
+ * at. The items carry the path of the list icon variant, the path of the other
+ * variants is derived from it.
+ */
+typedef enum artwork_variant
+{
+    ARTWORK_ICON,           /* List rows */
+    ARTWORK_COVER,          /* Mini player & notification cover */
+    ARTWORK_FULLSCREEN,     /* Fullscreen player cover */
+    ARTWORK_VARIANT_COUNT
+} artwork_variant;
+
+/* Largest dimension of a variant, in pixels */
+int
+artwork_variant_size( artwork_variant i_variant );
+
+/* Suffix of a variant file name, appended to the artwork base path */
+const char*
+artwork_variant_suffix( artwork_variant i_variant );
+
+/*
+ * Returns the path of the i_variant of the artwork whose list icon is
+ * psz_icon, formatted in psz_buf.
+ * Artworks that couldn't be scaled only have one variant: psz_icon is returned
+ * as is for them.
+ */
+const char*
+artwork_variant_path( const char* psz_icon, artwork_variant i_variant, char* psz_buf, size_t i_size );
+
+/*
+ * Records that the artwork whose list icon is psz_icon is being displayed, so
+ * that its variants are evicted after the ones that weren't displayed lately.
+ */
+void
+artwork_mark_used( const char* psz_icon );
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // ARTWORK_H_
@@ -27,6 +27,8 @@
 #include "common.h"
 #include "genre_item.h"
 
+#include <Eina.h>
+
 genre_item*
 genre_item_create(const char* psz_name)
 {
@@ -34,7 +36,8 @@ genre_item_create(const char* psz_name)
     if (p_item == NULL)
         return NULL;
     p_item->i_library_item_type = LIBRARY_ITEM_GENRE;
-    p_item->psz_name = strdup(psz_name);
+    p_item->i_refs = 1;
+    p_item->psz_name = eina_stringshare_add(psz_name);
     if (p_item->psz_name == NULL)
     {
         free(p_item);
@@ -50,6 +53,7 @@ genre_item_copy(const genre_item* p_item)
     if (p_new_item == NULL)
         return NULL;
     p_new_item->i_id = p_item->i_id;
+    p_new_item->i_nb_tracks = p_item->i_nb_tracks;
     return p_new_item;
 }
 
@@ -63,8 +67,8 @@ genre_item_identical(const genre_item* p_left, const genre_item* p_right)
 void
 genre_item_destroy(genre_item* p_item)
 {
-    if (p_item == NULL)
+    if (p_item == NULL || !library_item_unref((library_item*)p_item))
         return;
-    free(p_item->psz_name);
+    eina_stringshare_del(p_item->psz_name);
     free(p_item);
 }
@@ -37,7 +37,8 @@ typedef struct genre_item {
     LIBRARY_ITEM_COMMON
 
     unsigned int i_id;
-    char* psz_name;
+    const char* psz_name;           /* Interned */
+    uint32_t i_nb_tracks;
 } genre_item;
 
 genre_item*
@@ -0,0 +1,537 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <image_util.h>
+
+#include "artwork_store.hpp"
+
+// JPEG quality of the variants
+static const int ARTWORK_QUALITY = 85;
+// Files younger than this are never collected, they might belong to an
+// artwork the library didn't report yet
+static const time_t ARTWORK_GRACE_PERIOD = 60 * 60;
+static const char ARTWORK_INDEX[] = "artwork.idx";
+// Precision of the last use time, so that the index isn't rewritten each time
+// an artwork scrolls by
+static const time_t ARTWORK_USE_PRECISION = 60 * 60;
+
+std::mutex ArtworkStore::s_lock;
+std::string ArtworkStore::s_dir;
+std::unordered_map<std::string, ArtworkStore::Source> ArtworkStore::s_sources;
+std::unordered_map<std::string, time_t> ArtworkStore::s_undecodable;
+std::unordered_map<uint64_t, ArtworkStore::Entry> ArtworkStore::s_entries;
+bool ArtworkStore::s_dirty = false;
+
+void
+ArtworkStore::open( const std::string& dir )
+{
+    std::lock_guard<std::mutex> lock( s_lock );
+    s_dir = dir;
+    s_sources.clear();
+    s_undecodable.clear();
+    s_entries.clear();
+    std::ifstream index( dir + "/" + ARTWORK_INDEX );
+    std::string line;
+    while ( std::getline( index, line ) )
+    {
+        unsigned long long hash;
+        long long first, second;
+        int pos = 0;
+        if ( sscanf( line.c_str(), "E %llx %lld %lld %n", &hash, &first, &second, &pos ) == 3 && pos > 0 )
+        {
+            auto& entry = s_entries[hash];
+            entry.lastUsed = first;
+            entry.evicted = second;
+            entry.original = line.substr( pos );
+        }
+        else if ( sscanf( line.c_str(), "S %llx %lld %n", &hash, &first, &pos ) == 2 && pos > 0 )
+            s_sources[line.substr( pos )] = Source{ hash, static_cast<time_t>( first ) };
+        else if ( sscanf( line.c_str(), "U %lld %n", &first, &pos ) == 1 && pos > 0 )
+            s_undecodable[line.substr( pos )] = static_cast<time_t>( first );
+    }
+    s_dirty = false;
+}
+
+void
+ArtworkStore::save()
+{
+    std::string data;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock( s_lock );
+        if ( s_dirty == false || s_dir.empty() == true )
+            return;
+        char buff[64];
+        for ( const auto& e : s_entries )
+        {
+            snprintf( buff, sizeof( buff ), "E %016" PRIx64 " %lld %lld ", e.first,
+                      static_cast<long long>( e.second.lastUsed ), static_cast<long long>( e.second.evicted ) );
+            data += buff + e.second.original + '\n';
+        }
+        for ( const auto& s : s_sources )
+        {
+            snprintf( buff, sizeof( buff ), "S %016" PRIx64 " %lld ", s.second.hash,
+                      static_cast<long long>( s.second.mtime ) );
+            data += buff + s.first + '\n';
+        }
+        for ( const auto& u : s_undecodable )
+        {
+            snprintf( buff, sizeof( buff ), "U %lld ", static_cast<long long>( u.second ) );
+            data += buff + u.first + '\n';
+        }
+        s_dirty = false;
+        path = s_dir + "/" + ARTWORK_INDEX;
+    }
+    auto tmpPath = path + ".tmp";
+    FILE* f = fopen( tmpPath.c_str(), "wb" );
+    bool res = f != nullptr && fwrite( data.c_str(), 1, data.length(), f ) == data.length();
+    if ( f != nullptr && fclose( f ) != 0 )
+        res = false;
+    if ( res == false || rename( tmpPath.c_str(), path.c_str() ) != 0 )
+    {
+        LOGE( "Failed to save the artwork index" );
+        unlink( tmpPath.c_str() );
+        std::lock_guard<std::mutex> lock( s_lock );
+        s_dirty = true;
+    }
+}
+
+bool
+ArtworkStore::isScalable( const std::string& path )
+{
+    auto ext = path.rfind( '.' );
+    if ( ext == std::string::npos )
+        return false;
+    return strcasecmp( path.c_str() + ext, ".jpg" ) == 0 ||
+           strcasecmp( path.c_str() + ext, ".jpeg" ) == 0;
+}
+
+bool
+ArtworkStore::isSnapshot( const std::string& path )
+{
+    return path.compare( 0, s_dir.length(), s_dir ) == 0 && path[s_dir.length()] == '/';
+}
+
+bool
+ArtworkStore::hashFile( const std::string& path, uint64_t& hash )
+{
+    FILE* f = fopen( path.c_str(), "rb" );
+    if ( f == nullptr )
+        return false;
+    // FNV-1a
+    hash = 14695981039346656037ULL;
+    unsigned char buff[16 * 1024];
+    size_t size;
+    while ( ( size = fread( buff, 1, sizeof( buff ), f ) ) > 0 )
+    {
+        for ( size_t i = 0; i < size; ++i )
+            hash = ( hash ^ buff[i] ) * 1099511628211ULL;
+    }
+    bool res = ferror( f ) == 0;
+    fclose( f );
+    return res;
+}
+
+std::string
+ArtworkStore::basePath( uint64_t hash )
+{
+    char name[32];
+    snprintf( name, sizeof( name ), "/art-%016" PRIx64, hash );
+    return s_dir + name;
+}
+
+const char*
+ArtworkStore::icon( const std::string& path )
+{
+    if ( path.empty() == true )
+        return nullptr;
+    if ( isScalable( path ) == false )
+        return eina_stringshare_add( path.c_str() );
+    std::lock_guard<std::mutex> lock( s_lock );
+    // The original is displayed until the variants are there
+    auto source = s_sources.find( path );
+    if ( source == end( s_sources ) )
+        return eina_stringshare_add( path.c_str() );
+    auto entry = s_entries.find( source->second.hash );
+    if ( entry == end( s_entries ) )
+        return eina_stringshare_add( path.c_str() );
+    if ( entry->second.evicted != 0 )
+        return eina_stringshare_add( path.c_str() );
+    auto iconPath = basePath( source->second.hash ) + artwork_variant_suffix( ARTWORK_ICON );
+    return eina_stringshare_add( iconPath.c_str() );
+}
+
+void
+ArtworkStore::markUsed( const std::string& icon )
+{
+    std::lock_guard<std::mutex> lock( s_lock );
+    // The icon is either a variant, named after the hash of its artwork, or
+    // the artwork itself
+    unsigned long long hash;
+    auto prefix = s_dir + "/art-";
+    if ( icon.compare( 0, prefix.length(), prefix ) != 0 ||
+         sscanf( icon.c_str() + prefix.length(), "%16llx", &hash ) != 1 )
+    {
+        auto source = s_sources.find( icon );
+        if ( source == end( s_sources ) )
+            return;
+        hash = source->second.hash;
+    }
+    auto entry = s_entries.find( hash );
+    if ( entry == end( s_entries ) )
+        return;
+    auto now = time( nullptr );
+    if ( now - entry->second.lastUsed < ARTWORK_USE_PRECISION )
+        return;
+    entry->second.lastUsed = now;
+    s_dirty = true;
+}
+
+void
+artwork_mark_used( const char* psz_icon )
+{
+    if ( psz_icon != nullptr )
+        ArtworkStore::markUsed( psz_icon );
+}
+
+bool
+ArtworkStore::writeVariant( const std::string& base, artwork_variant variant,
+                            const unsigned char* src, int width, int height,
+                            unsigned char** dest, int* destWidth, int* destHeight )
+{
+    auto size = artwork_variant_size( variant );
+    auto largest = std::max( width, height );
+    *dest = nullptr;
+    *destWidth = width;
+    *destHeight = height;
+    if ( largest > size )
+    {
+        // Even dimensions, as some resizers require them
+        *destWidth = std::max( 2, width * size / largest ) & ~1;
+        *destHeight = std::max( 2, height * size / largest ) & ~1;
+        unsigned int bufferSize;
+        if ( image_util_calculate_buffer_size( *destWidth, *destHeight, IMAGE_UTIL_COLORSPACE_RGB888,
+                                               &bufferSize ) != IMAGE_UTIL_ERROR_NONE )
+            return false;
+        *dest = static_cast<unsigned char*>( malloc( bufferSize ) );
+        if ( *dest == nullptr )
+            return false;
+        if ( image_util_resize( *dest, destWidth, destHeight, src, width, height,
+                                IMAGE_UTIL_COLORSPACE_RGB888 ) != IMAGE_UTIL_ERROR_NONE )
+            return false;
+        src = *dest;
+    }
+    // Write to a temporary file, so that a variant is either complete or missing
+    auto path = base + artwork_variant_suffix( variant );
+    auto tmpPath = path + ".tmp";
+    if ( image_util_encode_jpeg( src, *destWidth, *destHeight, IMAGE_UTIL_COLORSPACE_RGB888,
+                                 ARTWORK_QUALITY, tmpPath.c_str() ) != IMAGE_UTIL_ERROR_NONE )
+    {
+        unlink( tmpPath.c_str() );
+        return false;
+    }
+    if ( rename( tmpPath.c_str(), path.c_str() ) != 0 )
+    {
+        unlink( tmpPath.c_str() );
+        return false;
+    }
+    return true;
+}
+
+ArtworkStore::WriteResult
+ArtworkStore::writeVariants( const std::string& path, const std::string& base )
+{
+    unsigned char* pixels;
+    int width, height;
+    unsigned int size;
+    if ( image_util_decode_jpeg( path.c_str(), IMAGE_UTIL_COLORSPACE_RGB888, &pixels,
+                                 &width, &height, &size ) != IMAGE_UTIL_ERROR_NONE )
+    {
+        LOGW( "Failed to decode artwork %s", path.c_str() );
+        return WriteResult::Undecodable;
+    }
+    // Each variant is scaled from the previous, larger one. The icon is
+    // written last, since it tells that all variants are there.
+    const artwork_variant variants[] = { ARTWORK_FULLSCREEN, ARTWORK_COVER, ARTWORK_ICON };
+    bool res = true;
+    for ( auto v : variants )
+    {
+        unsigned char* scaled;
+        int scaledWidth, scaledHeight;
+        res = writeVariant( base, v, pixels, width, height, &scaled, &scaledWidth, &scaledHeight );
+        if ( scaled != nullptr )
+        {
+            free( pixels );
+            pixels = scaled;
+            width = scaledWidth;
+            height = scaledHeight;
+        }
+        if ( res == false )
+        {
+            LOGW( "Failed to write artwork %s%s", base.c_str(), artwork_variant_suffix( v ) );
+            break;
+        }
+    }
+    free( pixels );
+    return res == true ? WriteResult::Written : WriteResult::Failed;
+}
+
+void
+ArtworkStore::deduplicate( const std::string& path, uint64_t hash )
+{
+    // Only the library snapshots are ours to replace. The media library
+    // writes each of them once, when parsing its media, so sharing their
+    // inode is safe.
+    if ( isSnapshot( path ) == false )
+        return;
+    std::string original;
+    {
+        std::lock_guard<std::mutex> lock( s_lock );
+        auto& entry = s_entries[hash];
+        if ( entry.original.empty() == true || entry.original == path )
+        {
+            entry.original = path;
+            s_dirty = true;
+            return;
+        }
+        original = entry.original;
+    }
+    struct stat src, dst;
+    if ( stat( original.c_str(), &src ) != 0 )
+    {
+        std::lock_guard<std::mutex> lock( s_lock );
+        s_entries[hash].original = path;
+        s_dirty = true;
+        return;
+    }
+    if ( stat( path.c_str(), &dst ) != 0 || src.st_size != dst.st_size ||
+         ( src.st_dev == dst.st_dev && src.st_ino == dst.st_ino ) )
+        return;
+    auto tmpPath = path + ".tmp";
+    if ( link( original.c_str(), tmpPath.c_str() ) != 0 || rename( tmpPath.c_str(), path.c_str() ) != 0 )
+        unlink( tmpPath.c_str() );
+}
+
+bool
+ArtworkStore::generate( const std::string& path )
+{
+    if ( path.empty() == true || isScalable( path ) == false )
+        return false;
+    struct stat st;
+    if ( stat( path.c_str(), &st ) != 0 )
+        return false;
+    {
+        std::lock_guard<std::mutex> lock( s_lock );
+        auto undecodable = s_undecodable.find( path );
+        if ( undecodable != end( s_undecodable ) && undecodable->second == st.st_mtime )
+            return false;
+        auto source = s_sources.find( path );
+        if ( source != end( s_sources ) && source->second.mtime == st.st_mtime )
+        {
+            // Evicted variants are only generated again once they're wanted
+            auto entry = s_entries.find( source->second.hash );
+            if ( entry != end( s_entries ) &&
+                 ( entry->second.evicted == 0 || entry->second.lastUsed <= entry->second.evicted ) )
+                return false;
+        }
+    }
+    uint64_t hash;
+    if ( hashFile( path, hash ) == false )
+        return false;
+    // Identical artworks share their variants
+    auto base = basePath( hash );
+    struct stat icon;
+    if ( stat( ( base + artwork_variant_suffix( ARTWORK_ICON ) ).c_str(), &icon ) != 0 )
+    {
+        auto res = writeVariants( path, base );
+        if ( res == WriteResult::Undecodable )
+        {
+            // The original keeps being displayed. Other failures, such as a
+            // full disk, are retried the next time the artwork is checked.
+            std::lock_guard<std::mutex> lock( s_lock );
+            s_undecodable[path] = st.st_mtime;
+            s_dirty = true;
+        }
+        if ( res != WriteResult::Written )
+            return false;
+    }
+    deduplicate( path, hash );
+    // Linking the snapshot changed its modification time
+    if ( stat( path.c_str(), &st ) != 0 )
+        return false;
+    std::lock_guard<std::mutex> lock( s_lock );
+    auto& entry = s_entries[hash];
+    entry.evicted = 0;
+    if ( entry.lastUsed == 0 )
+        entry.lastUsed = time( nullptr );
+    s_sources[path] = Source{ hash, st.st_mtime };
+    s_undecodable.erase( path );
+    s_dirty = true;
+    return true;
+}
+
+uint64_t
+ArtworkStore::deleteVariants( uint64_t hash )
+{
+    auto base = basePath( hash );
+    uint64_t size = 0;
+    for ( int v = 0; v < ARTWORK_VARIANT_COUNT; ++v )
+    {
+        auto path = base + artwork_variant_suffix( static_cast<artwork_variant>( v ) );
+        struct stat st;
+        if ( stat( path.c_str(), &st ) == 0 && unlink( path.c_str() ) == 0 )
+            size += st.st_size;
+    }
+    return size;
+}
+
+void
+ArtworkStore::collect( const std::unordered_set<std::string>& live, uint64_t budget )
+{
+    std::string dir;
+    std::unordered_set<std::string> variants;
+    std::vector<std::pair<time_t, uint64_t>> lru;
+    {
+        std::lock_guard<std::mutex> lock( s_lock );
+        if ( s_dir.empty() == true )
+            return;
+        dir = s_dir;
+        for ( auto it = begin( s_undecodable ); it != end( s_undecodable ); )
+        {
+            if ( live.find( it->first ) == end( live ) )
+            {
+                it = s_undecodable.erase( it );
+                s_dirty = true;
+            }
+            else
+                ++it;
+        }
+        for ( auto it = begin( s_sources ); it != end( s_sources ); )
+        {
+            if ( live.find( it->first ) == end( live ) )
+            {
+                it = s_sources.erase( it );
+                s_dirty = true;
+            }
+            else
+                ++it;
+        }
+        std::unordered_set<uint64_t> used;
+        for ( const auto& s : s_sources )
+            used.insert( s.second.hash );
+        for ( auto it = begin( s_entries ); it != end( s_entries ); )
+        {
+            // The variants of unused entries are deleted as orphans below
+            if ( used.find( it->first ) == end( used ) )
+            {
+                it = s_entries.erase( it );
+                s_dirty = true;
+                continue;
+            }
+            if ( it->second.evicted == 0 )
+            {
+                auto base = basePath( it->first );
+                for ( int v = 0; v < ARTWORK_VARIANT_COUNT; ++v )
+                    variants.insert( base + artwork_variant_suffix( static_cast<artwork_variant>( v ) ) );
+                lru.emplace_back( it->second.lastUsed, it->first );
+            }
+            ++it;
+        }
+    }
+
+    // Live snapshots are matched by inode, since the library might spell
+    // their path differently
+    std::unordered_set<uint64_t> liveInodes;
+    for ( const auto& path : live )
+    {
+        struct stat st;
+        if ( stat( path.c_str(), &st ) == 0 )
+            liveInodes.insert( st.st_ino );
+    }
+    auto indexPath = dir + "/" + ARTWORK_INDEX;
+    auto now = time( nullptr );
+    uint64_t variantsSize = 0;
+    unsigned int nbDeleted = 0;
+    DIR* d = opendir( dir.c_str() );
+    if ( d == nullptr )
+        return;
+    struct dirent* ent;
+    while ( ( ent = readdir( d ) ) != nullptr )
+    {
+        if ( ent->d_name[0] == '.' )
+            continue;
+        auto path = dir + "/" + ent->d_name;
+        struct stat st;
+        if ( stat( path.c_str(), &st ) != 0 || S_ISREG( st.st_mode ) == 0 )
+            continue;
+        if ( variants.find( path ) != end( variants ) )
+        {
+            variantsSize += st.st_size;
+            continue;
+        }
+        if ( path == indexPath || liveInodes.find( st.st_ino ) != end( liveInodes ) ||
+             now - st.st_mtime < ARTWORK_GRACE_PERIOD )
+            continue;
+        if ( unlink( path.c_str() ) == 0 )
+            ++nbDeleted;
+    }
+    closedir( d );
+
+    unsigned int nbEvicted = 0;
+    if ( variantsSize > budget )
+    {
+        std::sort( begin( lru ), end( lru ) );
+        for ( const auto& e : lru )
+        {
+            if ( variantsSize <= budget )
+                break;
+            variantsSize -= std::min( deleteVariants( e.second ), variantsSize );
+            ++nbEvicted;
+            std::lock_guard<std::mutex> lock( s_lock );
+            auto it = s_entries.find( e.second );
+            if ( it != end( s_entries ) )
+            {
+                it->second.evicted = now;
+                s_dirty = true;
+            }
+        }
+    }
+    LOGI( "Artwork store: deleted %u orphan files, evicted %u artworks, %" PRIu64 " bytes of variants left",
+          nbDeleted, nbEvicted, variantsSize );
+    save();
+}
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#ifndef ARTWORK_STORE_HPP_
+# define ARTWORK_STORE_HPP_
+
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "media/artwork.h"
+
+/*
+ * Stores the scaled variants of the snapshots & artworks, written at scan time.
+ * Variants are named after the content hash of their artwork, so that
+ * identical pictures, such as the cover art embedded in every track of an
+ * album, are only scaled and stored once. Identical library snapshots are
+ * hard linked to a single copy.
+ * An index of the artworks, kept in the snapshot directory, remembers their
+ * hash and when their variants were last used. Only JPEG pictures are scaled,
+ * the other ones are displayed as is, and so are the JPEG pictures that can't
+ * be decoded. Those are remembered until they change, so that they aren't
+ * decoded again at each start.
+ */
+class ArtworkStore
+{
+public:
+    // Loads the index of the store kept in dir
+    static void open( const std::string& dir );
+    // Returns the interned path of the list icon of the artwork at path.
+    // It is the path itself until the variants have been generated, or if
+    // the artwork can't be scaled or its variants were evicted.
+    static const char* icon( const std::string& path );
+    // Records that the artwork of the icon returned by icon() is displayed
+    static void markUsed( const std::string& icon );
+    // Writes the variants of the artwork at path, if they are missing or
+    // older than the artwork. Returns true if its icon changed.
+    static bool generate( const std::string& path );
+    // Deletes the files of the snapshot directory that none of the live
+    // artworks use, then evicts the least recently used variants until they
+    // fit in budget bytes.
+    static void collect( const std::unordered_set<std::string>& live, uint64_t budget );
+    // Saves the index, if it changed
+    static void save();
+
+private:
+    struct Source
+    {
+        uint64_t hash;
+        time_t mtime;
+    };
+
+    struct Entry
+    {
+        Entry() : lastUsed( 0 ), evicted( 0 ) {}
+        time_t lastUsed;
+        // When the variants got evicted, 0 if they are on disk
+        time_t evicted;
+        // Library snapshot that identical snapshots get linked to
+        std::string original;
+    };
+
+    static bool isScalable( const std::string& path );
+    static bool isSnapshot( const std::string& path );
+    static bool hashFile( const std::string& path, uint64_t& hash );
+    static std::string basePath( uint64_t hash );
+    enum class WriteResult
+    {
+        Written,
+        Undecodable,
+        Failed,
+    };
+    static WriteResult writeVariants( const std::string& path, const std::string& base );
+    static bool writeVariant( const std::string& base, artwork_variant variant,
+                              const unsigned char* src, int width, int height,
+                              unsigned char** dest, int* destWidth, int* destHeight );
+    static void deduplicate( const std::string& path, uint64_t hash );
+    static uint64_t deleteVariants( uint64_t hash );
+
+private:
+    static std::mutex s_lock;
+    static std::string s_dir;
+    static std::unordered_map<std::string, Source> s_sources;
+    // Modification time of the artworks that couldn't be decoded
+    static std::unordered_map<std::string, time_t> s_undecodable;
+    static std::unordered_map<uint64_t, Entry> s_entries;
+    static bool s_dirty;
+};
+
+#endif // ARTWORK_STORE_HPP_
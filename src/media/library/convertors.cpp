@@ -28,6 +28,7 @@
 
 #include <ctime>
 
+#include "artwork_store.hpp"
 #include "media_library_private.hpp"
 #include "IVideoTrack.h"
 #include "IAlbum.h"
@@ -37,37 +38,158 @@
 #include "IGenre.h"
 #include "media/genre_item.h"
 
+/* Strips the file:// scheme and decodes the URL, in place */
 static char*
-path_from_url(const char* psz_str)
+path_from_url_in_place(char* psz_str)
 {
     if (psz_str == NULL || *psz_str == 0)
         return NULL;
-    if (strncmp(psz_str, "file://", 7) == 0)
-        psz_str += 7;
-    size_t len = strlen(psz_str);
-    char* psz_res;
-    char* psz_dest = psz_res = (char*)malloc((len + 1) * sizeof(*psz_dest));
+    const char* psz_src = psz_str;
+    if (strncmp(psz_src, "file://", 7) == 0)
+        psz_src += 7;
+    char* psz_dest = psz_str;
 
-    while (*psz_str)
+    while (*psz_src)
     {
-        if (*psz_str == '%' && psz_str[1] != 0 && psz_str[2] != 0)
+        if (*psz_src == '%' && psz_src[1] != 0 && psz_src[2] != 0)
         {
-            sscanf(psz_str + 1,"%02x",(int*)psz_dest);
-            ++psz_dest;
-            psz_str += 3;
+            unsigned int c;
+            sscanf(psz_src + 1,"%02x",&c);
+            *psz_dest++ = (char)c;
+            psz_src += 3;
         }
         else
         {
-            *psz_dest++ = *psz_str++;
+            *psz_dest++ = *psz_src++;
         }
     }
     *psz_dest = 0;
-    return psz_res;
+    return psz_str;
 }
 
+std::string
+pathFromUrl( const std::string& url )
+{
+    if ( url.empty() == true )
+        return url;
+    std::string path( url );
+    path.resize( strlen( path_from_url_in_place( &path[0] ) ) );
+    return path;
+}
+
+/* The tracks fall back to the artwork of their album */
+static std::string
+audioArtwork( MediaPtr media, AlbumPtr album )
+{
+    auto artwork = media->thumbnail();
+    if ( artwork.empty() == true )
+        artwork = album->artworkMrl();
+    return pathFromUrl( artwork );
+}
+
+
+// Number of albums, artists & genres fetched one by one before fetching them all
+static const unsigned int ML_PREFETCH_THRESHOLD = 32;
+
+MediaItemConvertor::MediaItemConvertor( IMediaLibrary* ml )
+    : m_ml( ml )
+    , m_nbMisses( 0 )
+    , m_prefetched( false )
+{
+}
+
+bool
+MediaItemConvertor::prefetch()
+{
+    if ( m_prefetched == true || m_ml == nullptr || ++m_nbMisses < ML_PREFETCH_THRESHOLD )
+        return false;
+    m_prefetched = true;
+    for ( auto& a : m_ml->albums() )
+        m_albums.emplace( a->id(), a );
+    for ( auto& a : m_ml->artists() )
+        m_artists.emplace( a->id(), a );
+    for ( auto& g : m_ml->genres() )
+        m_genres.emplace( g->id(), g );
+    return true;
+}
+
+AlbumPtr
+MediaItemConvertor::album( AlbumTrackPtr track )
+{
+    auto id = track->albumId();
+    auto it = m_albums.find( id );
+    if ( it != end( m_albums ) )
+        return it->second;
+    if ( prefetch() == true )
+    {
+        it = m_albums.find( id );
+        if ( it != end( m_albums ) )
+            return it->second;
+    }
+    auto album = track->album();
+    m_albums.emplace( id, album );
+    return album;
+}
+
+ArtistPtr
+MediaItemConvertor::artist( AlbumTrackPtr track )
+{
+    auto id = track->artistId();
+    auto it = m_artists.find( id );
+    if ( it != end( m_artists ) )
+        return it->second;
+    if ( prefetch() == true )
+    {
+        it = m_artists.find( id );
+        if ( it != end( m_artists ) )
+            return it->second;
+    }
+    auto artist = track->artist();
+    m_artists.emplace( id, artist );
+    return artist;
+}
+
+GenrePtr
+MediaItemConvertor::genre( AlbumTrackPtr track )
+{
+    auto id = track->genreId();
+    auto it = m_genres.find( id );
+    if ( it != end( m_genres ) )
+        return it->second;
+    if ( prefetch() == true )
+    {
+        it = m_genres.find( id );
+        if ( it != end( m_genres ) )
+            return it->second;
+    }
+    auto genre = track->genre();
+    m_genres.emplace( id, genre );
+    return genre;
+}
+
+void
+MediaItemConvertor::newArena()
+{
+    // The items converted so far keep their arena alive
+    m_arena.reset();
+}
+
+std::string
+MediaItemConvertor::artwork( MediaPtr media )
+{
+    if ( media->type() == IMedia::Type::VideoType )
+        return media->thumbnail();
+    auto albumTrack = media->albumTrack();
+    if ( albumTrack == nullptr )
+        return std::string();
+    auto album = this->album( albumTrack );
+    if ( album == nullptr )
+        return std::string();
+    return audioArtwork( media, album );
+}
 
 media_item*
-fileToMediaItem( MediaPtr media )
+MediaItemConvertor::operator()( MediaPtr media )
 {
     auto type = MEDIA_ITEM_TYPE_UNKNOWN;
     switch ( media->type() )
@@ -90,7 +212,13 @@ fileToMediaItem( MediaPtr media )
     }
     const auto& file = files[0];
 
-    auto mi = media_item_create( file->mrl().c_str(), type );
+    if ( m_arena == nullptr )
+    {
+        m_arena.reset( media_item_arena_create(), &media_item_arena_release );
+        if ( m_arena == nullptr )
+            return nullptr;
+    }
+    auto mi = media_item_arena_create_item( m_arena.get(), file->mrl().c_str(), type );
     if ( mi == nullptr )
     {
         //FIXME: What should we do? This won't be run again until the next time
@@ -100,7 +228,7 @@ fileToMediaItem( MediaPtr media )
         return nullptr;
     }
     mi->i_id = media->id();
-    media_item_set_meta(mi, MEDIA_ITEM_META_TITLE, media->title().c_str());
+    media_item_arena_set_meta(mi, MEDIA_ITEM_META_TITLE, media->title().c_str());
 
     mi->i_duration = media->duration();
     if ( media->type() == IMedia::Type::VideoType )
@@ -114,32 +242,29 @@ fileToMediaItem( MediaPtr media )
             mi->i_w = vtrack->width();
             mi->i_h = vtrack->height();
         }
-        if (media->thumbnail().length() > 0)
-            mi->psz_snapshot = strdup(media->thumbnail().c_str());
+        mi->psz_snapshot = ArtworkStore::icon( media->thumbnail() );
     }
     else if ( media->type() == IMedia::Type::AudioType )
     {
         auto albumTrack = media->albumTrack();
         if (albumTrack != nullptr)
         {
-            auto album = albumTrack->album();
+            auto album = this->album( albumTrack );
             if (album != nullptr)
             {
-                media_item_set_meta(mi, MEDIA_ITEM_META_ALBUM, album->title().c_str());
-                auto year = media->releaseDate();
-                if (year != 0)
-                {
-                    media_item_set_meta(mi, MEDIA_ITEM_META_YEAR, std::to_string(year).c_str());
-                }
-                auto artwork = media->thumbnail();
-                if ( artwork.empty() == true )
-                    artwork = album->artworkMrl();
-                mi->psz_snapshot = path_from_url(artwork.c_str());
+                media_item_arena_set_meta(mi, MEDIA_ITEM_META_ALBUM, album->title().c_str());
+                mi->i_year = media->releaseDate();
+                mi->psz_snapshot = ArtworkStore::icon( audioArtwork( media, album ) );
             }
             mi->i_track_number = albumTrack->trackNumber();
-            auto artist = albumTrack->artist();
+            mi->i_album_id = albumTrack->albumId();
+            mi->i_artist_id = albumTrack->artistId();
+            auto artist = this->artist( albumTrack );
             if (artist != nullptr)
-                media_item_set_meta(mi, MEDIA_ITEM_META_ARTIST, artist->name().c_str());
+                media_item_arena_set_meta(mi, MEDIA_ITEM_META_ARTIST, artist->name().c_str());
+            auto genre = this->genre( albumTrack );
+            if (genre != nullptr)
+                media_item_arena_set_meta(mi, MEDIA_ITEM_META_GENRE, genre->name().c_str());
         }
     }
     return mi;
@@ -154,7 +279,8 @@ albumToAlbumItem( AlbumPtr album )
     p_item->i_id = album->id();
     p_item->i_release_date = album->releaseYear();
     p_item->i_nb_tracks = album->nbTracks();
-    p_item->psz_artwork = path_from_url(album->artworkMrl().c_str());
+    p_item->i_duration = album->duration();
+    p_item->psz_artwork = ArtworkStore::icon( pathFromUrl( album->artworkMrl() ) );
     return p_item;
 }
 
@@ -165,11 +291,8 @@ artistToArtistItem( ArtistPtr artist )
     if (p_item == nullptr)
         return nullptr;
     p_item->i_id = artist->id();
-    if (artist->artworkMrl().empty() == false)
-        p_item->psz_artwork = path_from_url( artist->artworkMrl().c_str() );
-
-    auto albums = artist->albums();
-    p_item->i_nb_albums = albums.size();
+    p_item->psz_artwork = ArtworkStore::icon( pathFromUrl( artist->artworkMrl() ) );
+    p_item->i_nb_albums = artist->nbAlbums();
     return p_item;
 }
 
@@ -180,5 +303,6 @@ genreToGenreItem( GenrePtr genre )
     if ( p_item == nullptr )
         return nullptr;
     p_item->i_id = genre->id();
+    p_item->i_nb_tracks = genre->nbTracks();
     return p_item;
 }
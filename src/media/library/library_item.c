@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include "media/media_item.h"
+#include "media/album_item.h"
+#include "media/artist_item.h"
+#include "media/genre_item.h"
+
+int64_t
+library_item_get_id(const library_item* p_item)
+{
+    switch (p_item->i_library_item_type)
+    {
+    case LIBRARY_ITEM_MEDIA:
+        return ((const media_item*)p_item)->i_id;
+    case LIBRARY_ITEM_ALBUM:
+        return ((const album_item*)p_item)->i_id;
+    case LIBRARY_ITEM_ARTIST:
+        return ((const artist_item*)p_item)->i_id;
+    case LIBRARY_ITEM_GENRE:
+        return ((const genre_item*)p_item)->i_id;
+    }
+    return 0;
+}
+
+const char*
+library_item_get_artwork(const library_item* p_item)
+{
+    switch (p_item->i_library_item_type)
+    {
+    case LIBRARY_ITEM_MEDIA:
+        return ((const media_item*)p_item)->psz_snapshot;
+    case LIBRARY_ITEM_ALBUM:
+        return ((const album_item*)p_item)->psz_artwork;
+    case LIBRARY_ITEM_ARTIST:
+        return ((const artist_item*)p_item)->psz_artwork;
+    case LIBRARY_ITEM_GENRE:
+        return NULL;
+    }
+    return NULL;
+}
+
+/* Interned strings are compared by pointer */
+static bool
+string_equal(const char* psz_left, const char* psz_right)
+{
+    if (psz_left == psz_right)
+        return true;
+    if (psz_left == NULL || psz_right == NULL)
+        return false;
+    return strcmp(psz_left, psz_right) == 0;
+}
+
+static bool
+media_item_equal(const media_item* p_left, const media_item* p_right)
+{
+    if (p_left->i_id != p_right->i_id || p_left->i_type != p_right->i_type ||
+            p_left->psz_path != p_right->psz_path ||
+            p_left->psz_snapshot != p_right->psz_snapshot ||
+            p_left->i_duration != p_right->i_duration ||
+            p_left->i_w != p_right->i_w || p_left->i_h != p_right->i_h ||
+            p_left->i_track_number != p_right->i_track_number ||
+            p_left->i_year != p_right->i_year)
+        return false;
+    for (int i = 0; i < MEDIA_ITEM_META_COUNT; ++i)
+    {
+        if (!string_equal(p_left->psz_metas[i], p_right->psz_metas[i]))
+            return false;
+    }
+    return true;
+}
+
+bool
+library_item_equal(const library_item* p_left, const library_item* p_right)
+{
+    if (p_left == p_right)
+        return true;
+    if (p_left->i_library_item_type != p_right->i_library_item_type)
+        return false;
+    switch (p_left->i_library_item_type)
+    {
+    case LIBRARY_ITEM_MEDIA:
+        return media_item_equal((const media_item*)p_left, (const media_item*)p_right);
+    case LIBRARY_ITEM_ALBUM:
+    {
+        const album_item* p_l = (const album_item*)p_left;
+        const album_item* p_r = (const album_item*)p_right;
+        return p_l->i_id == p_r->i_id && p_l->psz_name == p_r->psz_name &&
+                p_l->psz_artwork == p_r->psz_artwork &&
+                string_equal(p_l->psz_summary, p_r->psz_summary) &&
+                p_l->i_release_date == p_r->i_release_date &&
+                p_l->i_nb_tracks == p_r->i_nb_tracks &&
+                p_l->i_duration == p_r->i_duration;
+    }
+    case LIBRARY_ITEM_ARTIST:
+    {
+        const artist_item* p_l = (const artist_item*)p_left;
+        const artist_item* p_r = (const artist_item*)p_right;
+        return p_l->i_id == p_r->i_id && p_l->psz_name == p_r->psz_name &&
+                p_l->psz_artwork == p_r->psz_artwork &&
+                p_l->i_nb_albums == p_r->i_nb_albums;
+    }
+    case LIBRARY_ITEM_GENRE:
+    {
+        const genre_item* p_l = (const genre_item*)p_left;
+        const genre_item* p_r = (const genre_item*)p_right;
+        return p_l->i_id == p_r->i_id && p_l->psz_name == p_r->psz_name &&
+                p_l->i_nb_tracks == p_r->i_nb_tracks;
+    }
+    }
+    return false;
+}
+
+/* Items are released from the main loop, but can be created and held by the
+ * media library threads */
+void*
+library_item_hold(const library_item* p_item)
+{
+    library_item* p_mutable_item = (library_item*)p_item;
+    __atomic_add_fetch(&p_mutable_item->i_refs, 1, __ATOMIC_RELAXED);
+    return p_mutable_item;
+}
+
+bool
+library_item_unref(library_item* p_item)
+{
+    return __atomic_sub_fetch(&p_item->i_refs, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+bool
+library_item_is_shared(const library_item* p_item)
+{
+    return __atomic_load_n(&p_item->i_refs, __ATOMIC_ACQUIRE) > 1;
+}
+
+void
+library_item_destroy(library_item* p_item)
+{
+    if (p_item == NULL)
+        return;
+    switch (p_item->i_library_item_type)
+    {
+    case LIBRARY_ITEM_MEDIA:
+        media_item_destroy((media_item*)p_item);
+        break;
+    case LIBRARY_ITEM_ALBUM:
+        album_item_destroy((album_item*)p_item);
+        break;
+    case LIBRARY_ITEM_ARTIST:
+        artist_item_destroy((artist_item*)p_item);
+        break;
+    case LIBRARY_ITEM_GENRE:
+        genre_item_destroy((genre_item*)p_item);
+        break;
+    }
+}
@@ -27,6 +27,9 @@
  #ifndef LIBRARY_ITEM_H_
  # define LIBRARY_ITEM_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -42,8 +45,47 @@ typedef enum library_item_type
     LIBRARY_ITEM_GENRE
 } library_item_type;
 
+/*
+ * Items are reference counted, and shared as is between the media library,
+ * the lists and the play queue. The *_destroy functions release a reference,
+ * and only free the item when it was the last one.
+ * Shared items must not be modified, see media_item_writable.
+ */
 #define LIBRARY_ITEM_COMMON \
-    library_item_type i_library_item_type;
+    library_item_type i_library_item_type; \
+    int i_refs;
+
+struct library_item
+{
+    LIBRARY_ITEM_COMMON
+};
+
+/* Returns the media library ID of any kind of library item */
+int64_t
+library_item_get_id(const library_item* p_item);
+
+/* Returns true if both items hold the same information. They don't need to
+ * refer to the same library item */
+bool
+library_item_equal(const library_item* p_left, const library_item* p_right);
+
+/* Returns the path of the image representing the item, or NULL */
+const char*
+library_item_get_artwork(const library_item* p_item);
+
+/* Takes a reference on the item, and returns it */
+void*
+library_item_hold(const library_item* p_item);
+
+/* Drops a reference, returns true if it was the last one */
+bool
+library_item_unref(library_item* p_item);
+
+bool
+library_item_is_shared(const library_item* p_item);
+
+void
+library_item_destroy(library_item* p_item);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,470 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "library_snapshot.h"
+#include "system_storage.h"
+#include "media/media_item.h"
+#include "media/album_item.h"
+#include "media/artist_item.h"
+#include "media/genre_item.h"
+
+/*
+ * File layout, in native byte order:
+ * - header: magic, version, sort key, sort direction, item count
+ * - for each item: its library_item_type, followed by its fields. Strings
+ *   are stored as a 16 bits length followed by the characters, without the
+ *   trailing \0. NULL strings have a SNAPSHOT_NULL_STRING length.
+ * Bump SNAPSHOT_VERSION whenever the layout of an item changes.
+ */
+#define SNAPSHOT_MAGIC 0x4c434c56 /* "VLCL" */
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_NULL_STRING 0xFFFF
+
+typedef struct snapshot_reader
+{
+    const uint8_t* p_cur;
+    const uint8_t* p_end;
+    bool b_error;
+    /* Media items, and their strings, are allocated from this arena */
+    media_item_arena* p_arena;
+} snapshot_reader;
+
+static char*
+snapshot_get_path(const char* psz_name)
+{
+    char* psz_appdata = system_storage_appdata_get();
+    if (psz_appdata == NULL)
+        return NULL;
+    char* psz_path;
+    if (asprintf(&psz_path, "%s%s.snapshot", psz_appdata, psz_name) < 0)
+        psz_path = NULL;
+    free(psz_appdata);
+    return psz_path;
+}
+
+/* Writers */
+
+static void
+write_data(Eina_Binbuf* p_buf, const void* p_data, size_t i_size)
+{
+    eina_binbuf_append_length(p_buf, p_data, i_size);
+}
+
+#define WRITE_VALUE(buf, type, value) \
+    do { type v = (value); write_data(buf, &v, sizeof(v)); } while(0)
+
+static void
+write_string(Eina_Binbuf* p_buf, const char* psz_str)
+{
+    if (psz_str == NULL)
+    {
+        WRITE_VALUE(p_buf, uint16_t, SNAPSHOT_NULL_STRING);
+        return;
+    }
+    size_t i_len = strlen(psz_str);
+    if (i_len >= SNAPSHOT_NULL_STRING)
+        i_len = SNAPSHOT_NULL_STRING - 1;
+    WRITE_VALUE(p_buf, uint16_t, i_len);
+    write_data(p_buf, psz_str, i_len);
+}
+
+static void
+write_item(Eina_Binbuf* p_buf, const library_item* p_item)
+{
+    WRITE_VALUE(p_buf, uint8_t, p_item->i_library_item_type);
+    switch (p_item->i_library_item_type)
+    {
+    case LIBRARY_ITEM_MEDIA:
+    {
+        const media_item* p_mi = (const media_item*)p_item;
+        WRITE_VALUE(p_buf, uint32_t, p_mi->i_id);
+        WRITE_VALUE(p_buf, uint8_t, p_mi->i_type);
+        WRITE_VALUE(p_buf, int64_t, p_mi->i_duration);
+        WRITE_VALUE(p_buf, int32_t, p_mi->i_w);
+        WRITE_VALUE(p_buf, int32_t, p_mi->i_h);
+        WRITE_VALUE(p_buf, uint16_t, p_mi->i_track_number);
+        WRITE_VALUE(p_buf, uint16_t, p_mi->i_year);
+        write_string(p_buf, p_mi->psz_path);
+        write_string(p_buf, p_mi->psz_snapshot);
+        for (unsigned int i = 0; i < MEDIA_ITEM_META_COUNT; ++i)
+            write_string(p_buf, p_mi->psz_metas[i]);
+        break;
+    }
+    case LIBRARY_ITEM_ALBUM:
+    {
+        const album_item* p_album = (const album_item*)p_item;
+        WRITE_VALUE(p_buf, uint32_t, p_album->i_id);
+        WRITE_VALUE(p_buf, int64_t, p_album->i_release_date);
+        WRITE_VALUE(p_buf, uint32_t, p_album->i_nb_tracks);
+        WRITE_VALUE(p_buf, int64_t, p_album->i_duration);
+        write_string(p_buf, p_album->psz_name);
+        write_string(p_buf, p_album->psz_artwork);
+        break;
+    }
+    case LIBRARY_ITEM_ARTIST:
+    {
+        const artist_item* p_artist = (const artist_item*)p_item;
+        WRITE_VALUE(p_buf, uint32_t, p_artist->i_id);
+        WRITE_VALUE(p_buf, uint32_t, p_artist->i_nb_albums);
+        write_string(p_buf, p_artist->psz_name);
+        write_string(p_buf, p_artist->psz_artwork);
+        break;
+    }
+    case LIBRARY_ITEM_GENRE:
+    {
+        const genre_item* p_genre = (const genre_item*)p_item;
+        WRITE_VALUE(p_buf, uint32_t, p_genre->i_id);
+        WRITE_VALUE(p_buf, uint32_t, p_genre->i_nb_tracks);
+        write_string(p_buf, p_genre->psz_name);
+        break;
+    }
+    }
+}
+
+bool
+library_snapshot_save(const char* psz_name, const media_library_sort* p_sort,
+        const library_item* const* pp_items, unsigned int i_nb_items)
+{
+    if (i_nb_items > LIBRARY_SNAPSHOT_MAX_ITEMS)
+        i_nb_items = LIBRARY_SNAPSHOT_MAX_ITEMS;
+
+    Eina_Binbuf* p_buf = eina_binbuf_new();
+    if (p_buf == NULL)
+        return false;
+    WRITE_VALUE(p_buf, uint32_t, SNAPSHOT_MAGIC);
+    WRITE_VALUE(p_buf, uint16_t, SNAPSHOT_VERSION);
+    WRITE_VALUE(p_buf, uint8_t, p_sort->i_key);
+    WRITE_VALUE(p_buf, uint8_t, p_sort->b_descending);
+    WRITE_VALUE(p_buf, uint32_t, i_nb_items);
+    for (unsigned int i = 0; i < i_nb_items; ++i)
+        write_item(p_buf, pp_items[i]);
+
+    bool b_res = false;
+    char* psz_path = snapshot_get_path(psz_name);
+    char* psz_tmp_path = NULL;
+    if (psz_path == NULL || asprintf(&psz_tmp_path, "%s.tmp", psz_path) < 0)
+    {
+        psz_tmp_path = NULL;
+        goto end;
+    }
+
+    /* Write a temporary file first, so that a crash never leaves a truncated
+     * snapshot behind */
+    int fd = open(psz_tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        LOGE("Failed to create %s: %s", psz_tmp_path, strerror(errno));
+        goto end;
+    }
+    const unsigned char* p_data = eina_binbuf_string_get(p_buf);
+    size_t i_size = eina_binbuf_length_get(p_buf);
+    while (i_size > 0)
+    {
+        ssize_t i_written = write(fd, p_data, i_size);
+        if (i_written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        p_data += i_written;
+        i_size -= i_written;
+    }
+    close(fd);
+    if (i_size != 0 || rename(psz_tmp_path, psz_path) != 0)
+    {
+        LOGE("Failed to save the %s snapshot: %s", psz_name, strerror(errno));
+        unlink(psz_tmp_path);
+        goto end;
+    }
+    b_res = true;
+
+end:
+    free(psz_tmp_path);
+    free(psz_path);
+    eina_binbuf_free(p_buf);
+    return b_res;
+}
+
+/* Readers */
+
+static void
+read_data(snapshot_reader* p_reader, void* p_data, size_t i_size)
+{
+    if (p_reader->b_error || (size_t)(p_reader->p_end - p_reader->p_cur) < i_size)
+    {
+        p_reader->b_error = true;
+        memset(p_data, 0, i_size);
+        return;
+    }
+    memcpy(p_data, p_reader->p_cur, i_size);
+    p_reader->p_cur += i_size;
+}
+
+#define READ_VALUE(reader, type, dst) \
+    do { type v; read_data(reader, &v, sizeof(v)); (dst) = v; } while(0)
+
+/* Returns the next string and its length, without copying it */
+static const char*
+read_string_ref(snapshot_reader* p_reader, uint16_t* pi_len)
+{
+    READ_VALUE(p_reader, uint16_t, *pi_len);
+    if (p_reader->b_error || *pi_len == SNAPSHOT_NULL_STRING)
+        return NULL;
+    if ((size_t)(p_reader->p_end - p_reader->p_cur) < *pi_len)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    const char* psz_str = (const char*)p_reader->p_cur;
+    p_reader->p_cur += *pi_len;
+    return psz_str;
+}
+
+static char*
+read_string(snapshot_reader* p_reader)
+{
+    uint16_t i_len;
+    const char* psz_str = read_string_ref(p_reader, &i_len);
+    return psz_str != NULL ? strndup(psz_str, i_len) : NULL;
+}
+
+/* Same as read_string, but interns the string */
+static const char*
+read_shared_string(snapshot_reader* p_reader)
+{
+    uint16_t i_len;
+    const char* psz_str = read_string_ref(p_reader, &i_len);
+    return psz_str != NULL ? eina_stringshare_add_length(psz_str, i_len) : NULL;
+}
+
+/* Same as read_string, but copies the string into the reader arena */
+static char*
+read_arena_string(snapshot_reader* p_reader)
+{
+    uint16_t i_len;
+    const char* psz_str = read_string_ref(p_reader, &i_len);
+    if (psz_str == NULL)
+        return NULL;
+    return media_item_arena_strndup(p_reader->p_arena, psz_str, i_len);
+}
+
+static library_item*
+read_media(snapshot_reader* p_reader)
+{
+    uint32_t i_id;
+    uint8_t i_type;
+    int64_t i_duration;
+    int32_t i_w, i_h;
+    uint16_t i_track_number, i_year;
+    READ_VALUE(p_reader, uint32_t, i_id);
+    READ_VALUE(p_reader, uint8_t, i_type);
+    READ_VALUE(p_reader, int64_t, i_duration);
+    READ_VALUE(p_reader, int32_t, i_w);
+    READ_VALUE(p_reader, int32_t, i_h);
+    READ_VALUE(p_reader, uint16_t, i_track_number);
+    READ_VALUE(p_reader, uint16_t, i_year);
+    const char* psz_path = read_shared_string(p_reader);
+    if (psz_path == NULL)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    media_item* p_mi = media_item_arena_create_item(p_reader->p_arena, psz_path, (enum MEDIA_ITEM_TYPE)i_type);
+    eina_stringshare_del(psz_path);
+    if (p_mi == NULL)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    p_mi->i_id = i_id;
+    p_mi->i_duration = i_duration;
+    p_mi->i_w = i_w;
+    p_mi->i_h = i_h;
+    p_mi->i_track_number = i_track_number;
+    p_mi->i_year = i_year;
+    p_mi->psz_snapshot = read_shared_string(p_reader);
+    for (unsigned int i = 0; i < MEDIA_ITEM_META_COUNT; ++i)
+    {
+        if (i == MEDIA_ITEM_META_ARTIST || i == MEDIA_ITEM_META_ALBUM || i == MEDIA_ITEM_META_GENRE)
+            p_mi->psz_metas[i] = read_shared_string(p_reader);
+        else
+            p_mi->psz_metas[i] = read_arena_string(p_reader);
+    }
+    return (library_item*)p_mi;
+}
+
+static library_item*
+read_album(snapshot_reader* p_reader)
+{
+    uint32_t i_id, i_nb_tracks;
+    int64_t i_release_date, i_duration;
+    READ_VALUE(p_reader, uint32_t, i_id);
+    READ_VALUE(p_reader, int64_t, i_release_date);
+    READ_VALUE(p_reader, uint32_t, i_nb_tracks);
+    READ_VALUE(p_reader, int64_t, i_duration);
+    char* psz_name = read_string(p_reader);
+    album_item* p_album = album_item_create(psz_name != NULL ? psz_name : "");
+    free(psz_name);
+    if (p_album == NULL)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    p_album->i_id = i_id;
+    p_album->i_release_date = i_release_date;
+    p_album->i_nb_tracks = i_nb_tracks;
+    p_album->i_duration = i_duration;
+    p_album->psz_artwork = read_shared_string(p_reader);
+    return (library_item*)p_album;
+}
+
+static library_item*
+read_artist(snapshot_reader* p_reader)
+{
+    uint32_t i_id, i_nb_albums;
+    READ_VALUE(p_reader, uint32_t, i_id);
+    READ_VALUE(p_reader, uint32_t, i_nb_albums);
+    char* psz_name = read_string(p_reader);
+    artist_item* p_artist = artist_item_create(psz_name);
+    free(psz_name);
+    if (p_artist == NULL)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    p_artist->i_id = i_id;
+    p_artist->i_nb_albums = i_nb_albums;
+    p_artist->psz_artwork = read_shared_string(p_reader);
+    return (library_item*)p_artist;
+}
+
+static library_item*
+read_genre(snapshot_reader* p_reader)
+{
+    uint32_t i_id, i_nb_tracks;
+    READ_VALUE(p_reader, uint32_t, i_id);
+    READ_VALUE(p_reader, uint32_t, i_nb_tracks);
+    char* psz_name = read_string(p_reader);
+    genre_item* p_genre = genre_item_create(psz_name != NULL ? psz_name : "");
+    free(psz_name);
+    if (p_genre == NULL)
+    {
+        p_reader->b_error = true;
+        return NULL;
+    }
+    p_genre->i_id = i_id;
+    p_genre->i_nb_tracks = i_nb_tracks;
+    return (library_item*)p_genre;
+}
+
+static library_item*
+read_item(snapshot_reader* p_reader)
+{
+    uint8_t i_type;
+    READ_VALUE(p_reader, uint8_t, i_type);
+    if (p_reader->b_error)
+        return NULL;
+    switch (i_type)
+    {
+    case LIBRARY_ITEM_MEDIA:
+        return read_media(p_reader);
+    case LIBRARY_ITEM_ALBUM:
+        return read_album(p_reader);
+    case LIBRARY_ITEM_ARTIST:
+        return read_artist(p_reader);
+    case LIBRARY_ITEM_GENRE:
+        return read_genre(p_reader);
+    }
+    p_reader->b_error = true;
+    return NULL;
+}
+
+Eina_List*
+library_snapshot_load(const char* psz_name, const media_library_sort* p_sort)
+{
+    char* psz_path = snapshot_get_path(psz_name);
+    if (psz_path == NULL)
+        return NULL;
+    Eina_File* p_file = eina_file_open(psz_path, EINA_FALSE);
+    free(psz_path);
+    if (p_file == NULL)
+        return NULL;
+
+    Eina_List* p_items = NULL;
+    size_t i_size = eina_file_size_get(p_file);
+    const uint8_t* p_data = eina_file_map_all(p_file, EINA_FILE_SEQUENTIAL);
+    if (p_data == NULL)
+        goto end;
+
+    snapshot_reader reader = { p_data, p_data + i_size, false, NULL };
+    uint32_t i_magic, i_nb_items;
+    uint16_t i_version;
+    uint8_t i_sort_key, i_sort_descending;
+    READ_VALUE(&reader, uint32_t, i_magic);
+    READ_VALUE(&reader, uint16_t, i_version);
+    READ_VALUE(&reader, uint8_t, i_sort_key);
+    READ_VALUE(&reader, uint8_t, i_sort_descending);
+    READ_VALUE(&reader, uint32_t, i_nb_items);
+    /* A snapshot saved with another order would be reshuffled by the live
+     * query, which is worse than displaying nothing */
+    if (reader.b_error || i_magic != SNAPSHOT_MAGIC || i_version != SNAPSHOT_VERSION ||
+            i_sort_key != p_sort->i_key || (bool)i_sort_descending != p_sort->b_descending ||
+            i_nb_items > LIBRARY_SNAPSHOT_MAX_ITEMS)
+        goto unmap;
+
+    reader.p_arena = media_item_arena_create();
+    if (reader.p_arena == NULL)
+        goto unmap;
+    for (uint32_t i = 0; i < i_nb_items; ++i)
+    {
+        library_item* p_item = read_item(&reader);
+        if (p_item == NULL)
+            break;
+        p_items = eina_list_append(p_items, p_item);
+    }
+    /* The items keep the arena alive */
+    media_item_arena_release(reader.p_arena);
+    if (reader.b_error)
+    {
+        LOGW("Discarding invalid %s snapshot", psz_name);
+        library_item* p_item;
+        EINA_LIST_FREE(p_items, p_item)
+            library_item_destroy(p_item);
+    }
+
+unmap:
+    eina_file_map_free(p_file, (void*)p_data);
+end:
+    eina_file_close(p_file);
+    return p_items;
+}
@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#ifndef LIBRARY_SNAPSHOT_H_
+# define LIBRARY_SNAPSHOT_H_
+
+#include <stdbool.h>
+#include <Eina.h>
+
+#include "media/library/library_item.h"
+#include "media/library/media_library.hpp"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Snapshots are a copy of the first items of a list, saved in the application
+ * data directory once the list has been fetched from the media library.
+ * They are loaded when the list is created again, so that something can be
+ * displayed before the media library has answered the first query.
+ */
+
+/* Number of items to save, enough to fill a couple of screens */
+#define LIBRARY_SNAPSHOT_MAX_ITEMS 50
+
+/* Saves the given items as the psz_name snapshot, replacing any previous one */
+bool
+library_snapshot_save(const char* psz_name, const media_library_sort* p_sort,
+        const library_item* const* pp_items, unsigned int i_nb_items);
+
+/*
+ * Loads the psz_name snapshot.
+ * Returns a list of library_item, or NULL if there is no snapshot, if it is
+ * invalid, or if it was saved with another sort than p_sort.
+ * The items must be released with library_item_destroy.
+ */
+Eina_List*
+library_snapshot_load(const char* psz_name, const media_library_sort* p_sort);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBRARY_SNAPSHOT_H_
@@ -27,17 +27,23 @@
 #include "common.h"
 
 #include <Ecore.h>
+#include <algorithm>
+#include <functional>
 
 #include "IMediaLibrary.h"
 #include "IVideoTrack.h"
 #include "IArtist.h"
 #include "IAlbum.h"
+#include "IAlbumTrack.h"
 #include "IGenre.h"
+#include "artwork_store.hpp"
 #include "media_library_private.hpp"
 #include "system_storage.h"
+#include "preferences/preferences.h"
 
 media_library::media_library()
     : ml( NewMediaLibrary() )
+    , m_flushScheduled( false )
     , m_progressCb( nullptr )
     , m_progressData( nullptr )
 
@@ -46,65 +52,348 @@ media_library::media_library()
         throw std::runtime_error( "Failed to initialize MediaLibrary" );
 }
 
+media_library::~media_library()
+{
+    // The tasks use the members below, which are destroyed before the
+    // executor. Then stop the medialibrary threads, which call us back.
+    executor.stop();
+    ml.reset();
+}
+
 void
 media_library::onMediaAdded( std::vector<MediaPtr> media )
 {
+    MediaItemConvertor conv( ml.get() );
     for ( const auto& m : media )
-        sendFileUpdate( m, true );
+    {
+        auto item = conv( m );
+        indexMedia( item );
+        sendItemUpdate( reinterpret_cast<library_item*>( item ), true );
+    }
+    generateArtwork( std::move( media ) );
 }
 
 void
 media_library::onMediaUpdated( std::vector<MediaPtr> media )
 {
+    MediaItemConvertor conv( ml.get() );
     for ( const auto& m : media )
-        sendFileUpdate( m, false );
+    {
+        auto item = conv( m );
+        indexMedia( item );
+        sendItemUpdate( reinterpret_cast<library_item*>( item ), false );
+    }
+    generateArtwork( std::move( media ) );
 }
 
 void media_library::onMediaDeleted( std::vector<int64_t> ids )
 {
+    for ( auto id : ids )
+        m_searchIndex.remove( id );
+    sendItemsRemoved( LIBRARY_ITEM_MEDIA, ids );
+}
+
+// Disk budget of the artwork variants, in MB
+static const int ML_ARTWORK_DEFAULT_BUDGET = 64;
+
+// Number of results returned by a search
+static const size_t ML_SEARCH_MAX_RESULTS = 100;
+
+// Number of items handled by each task of the startup backfill
+static const size_t ML_INDEX_BATCH_SIZE = 200;
+static const size_t ML_ARTWORK_BATCH_SIZE = 8;
+
+static std::string
+meta_or_empty( const media_item* item, enum MEDIA_ITEM_META meta )
+{
+    return item->psz_metas[meta] != nullptr ? item->psz_metas[meta] : "";
+}
+
+void
+media_library::indexMedia( const media_item* item )
+{
+    if ( item == nullptr )
+        return;
+    std::string fields[SearchIndex::NbFields];
+    fields[SearchIndex::Title] = meta_or_empty( item, MEDIA_ITEM_META_TITLE );
+    fields[SearchIndex::Artist] = meta_or_empty( item, MEDIA_ITEM_META_ARTIST );
+    fields[SearchIndex::Album] = meta_or_empty( item, MEDIA_ITEM_META_ALBUM );
+    fields[SearchIndex::Genre] = meta_or_empty( item, MEDIA_ITEM_META_GENRE );
+    m_searchIndex.add( item->i_id, item->i_type, fields );
+}
+
+// Runs func on each item, in batches that are scheduled as background tasks
+// one after the other, so that list queries can run in between. done is
+// called after the last batch.
+template <typename T, typename Func, typename Done>
+static void
+for_each_batch( QueryExecutor& executor, std::shared_ptr<std::vector<T>> items, size_t offset,
+                size_t batchSize, Func func, Done done )
+{
+    executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [&executor, items, offset, batchSize, func, done]() {
+        auto last = std::min( offset + batchSize, items->size() );
+        for ( auto i = offset; i < last; ++i )
+            func( (*items)[i] );
+        if ( last < items->size() )
+            for_each_batch( executor, items, last, batchSize, func, done );
+        else
+            done();
+    });
+}
+
+void
+media_library::buildSearchIndex()
+{
+    // The batches run one at a time, they can share the album, artist &
+    // genre cache
+    auto conv = std::make_shared<MediaItemConvertor>( ml.get() );
+    auto index = [this, conv]( const std::pair<MediaPtr, MEDIA_ITEM_TYPE>& entry ) {
+        const auto& m = entry.first;
+        std::string fields[SearchIndex::NbFields];
+        fields[SearchIndex::Title] = m->title();
+        if ( entry.second == MEDIA_ITEM_TYPE_AUDIO )
+        {
+            auto track = m->albumTrack();
+            if ( track != nullptr )
+            {
+                auto album = conv->album( track );
+                if ( album != nullptr )
+                    fields[SearchIndex::Album] = album->title();
+                auto artist = conv->artist( track );
+                if ( artist != nullptr )
+                    fields[SearchIndex::Artist] = artist->name();
+                auto genre = conv->genre( track );
+                if ( genre != nullptr )
+                    fields[SearchIndex::Genre] = genre->name();
+            }
+        }
+        // Media added or updated meanwhile are more accurate
+        m_searchIndex.addIfMissing( m->id(), entry.second, fields );
+    };
+    auto media = std::make_shared<std::vector<std::pair<MediaPtr, MEDIA_ITEM_TYPE>>>();
+    for ( auto& m : ml->audioFiles() )
+        media->emplace_back( std::move( m ), MEDIA_ITEM_TYPE_AUDIO );
+    for ( auto& m : ml->videoFiles() )
+        media->emplace_back( std::move( m ), MEDIA_ITEM_TYPE_VIDEO );
+    for_each_batch( executor, media, 0, ML_INDEX_BATCH_SIZE, index, []() {
+        LOGI( "Search index built" );
+    });
+}
+
+std::vector<MediaPtr>
+media_library::search( const std::string& pattern, MEDIA_ITEM_TYPE type )
+{
+    std::vector<MediaPtr> res;
+    for ( auto id : m_searchIndex.search( pattern, type, ML_SEARCH_MAX_RESULTS ) )
+    {
+        // The media might have been removed since it got indexed
+        auto m = ml->media( id );
+        if ( m != nullptr )
+            res.push_back( m );
+    }
+    return res;
 }
 
 
 void media_library::onArtistsAdded( std::vector<ArtistPtr> artists )
 {
+    for ( const auto& a : artists )
+        sendItemUpdate( reinterpret_cast<library_item*>( artistToArtistItem( a ) ), true );
+    generateArtwork( std::move( artists ) );
 }
 
-void media_library::onArtistsModified( std::vector<ArtistPtr> artist )
+void media_library::onArtistsModified( std::vector<ArtistPtr> artists )
 {
+    for ( const auto& a : artists )
+        sendItemUpdate( reinterpret_cast<library_item*>( artistToArtistItem( a ) ), false );
+    generateArtwork( std::move( artists ) );
 }
 
 void media_library::onArtistsDeleted( std::vector<int64_t> ids )
 {
+    sendItemsRemoved( LIBRARY_ITEM_ARTIST, ids );
 }
 
 void media_library::onAlbumsAdded( std::vector<AlbumPtr> albums )
 {
+    for ( const auto& a : albums )
+        sendItemUpdate( reinterpret_cast<library_item*>( albumToAlbumItem( a ) ), true );
+    generateArtwork( std::move( albums ) );
 }
 
 void media_library::onAlbumsModified( std::vector<AlbumPtr> albums )
 {
+    for ( const auto& a : albums )
+        sendItemUpdate( reinterpret_cast<library_item*>( albumToAlbumItem( a ) ), false );
+    generateArtwork( std::move( albums ) );
+}
+
+void
+media_library::generateArtwork( std::vector<MediaPtr> media )
+{
+    executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [this, media]() {
+        MediaItemConvertor conv( ml.get() );
+        for ( const auto& m : media )
+        {
+            if ( ArtworkStore::generate( conv.artwork( m ) ) == true )
+                sendItemUpdate( reinterpret_cast<library_item*>( conv( m ) ), false );
+        }
+    });
+}
+
+void
+media_library::generateArtwork( std::vector<AlbumPtr> albums )
+{
+    executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [this, albums]() {
+        for ( const auto& a : albums )
+        {
+            if ( ArtworkStore::generate( pathFromUrl( a->artworkMrl() ) ) == true )
+                sendItemUpdate( reinterpret_cast<library_item*>( albumToAlbumItem( a ) ), false );
+        }
+    });
+}
+
+void
+media_library::generateArtwork( std::vector<ArtistPtr> artists )
+{
+    executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [this, artists]() {
+        for ( const auto& a : artists )
+        {
+            if ( ArtworkStore::generate( pathFromUrl( a->artworkMrl() ) ) == true )
+                sendItemUpdate( reinterpret_cast<library_item*>( artistToArtistItem( a ) ), false );
+        }
+    });
+}
+
+std::unordered_set<std::string>
+media_library::artworks()
+{
+    std::unordered_set<std::string> res;
+    auto add = [&res]( std::string path ) {
+        if ( path.empty() == false )
+            res.insert( std::move( path ) );
+    };
+    MediaItemConvertor conv( ml.get() );
+    for ( const auto& m : ml->audioFiles() )
+        add( conv.artwork( m ) );
+    for ( const auto& m : ml->videoFiles() )
+        add( conv.artwork( m ) );
+    for ( const auto& a : ml->albums() )
+        add( pathFromUrl( a->artworkMrl() ) );
+    for ( const auto& a : ml->artists() )
+        add( pathFromUrl( a->artworkMrl() ) );
+    return res;
+}
+
+void
+media_library::generateMissingArtwork()
+{
+    // Libraries scanned before the variants existed, or artworks that changed
+    // while the application wasn't running
+    auto paths = artworks();
+    auto pending = std::make_shared<std::vector<std::string>>( begin( paths ), end( paths ) );
+    auto changed = std::make_shared<bool>( false );
+    for_each_batch( executor, pending, 0, ML_ARTWORK_BATCH_SIZE, [changed]( const std::string& path ) {
+        *changed = ArtworkStore::generate( path ) || *changed;
+    }, [this, changed]() {
+        ArtworkStore::save();
+        LOGI( "Artwork variants generated" );
+        // Let the lists reload the items with their new icons
+        if ( *changed == true )
+            notifyChanged();
+    });
+}
+
+void
+media_library::collectArtwork()
+{
+    auto budget = preferences_get_index( PREF_ARTWORK_CACHE_SIZE, ML_ARTWORK_DEFAULT_BUDGET );
+    ArtworkStore::collect( artworks(), static_cast<uint64_t>( std::max( budget, 0 ) ) * 1024 * 1024 );
 }
 
 void media_library::onAlbumsDeleted( std::vector<int64_t> ids )
 {
+    sendItemsRemoved( LIBRARY_ITEM_ALBUM, ids );
+}
+
+void
+media_library::sendItemUpdate( library_item* item, bool added )
+{
+    if ( item == nullptr )
+        return;
+    queueUpdate( PendingUpdate( item, added ) );
+}
+
+void
+media_library::sendItemsRemoved( library_item_type type, const std::vector<int64_t>& ids )
+{
+    for ( auto id : ids )
+        queueUpdate( PendingUpdate( type, id ) );
 }
 
 void
-media_library::sendFileUpdate( MediaPtr file, bool added )
+media_library::queueUpdate( PendingUpdate update )
 {
-    auto item = fileToMediaItem( file );
-    auto ctx = new FileUpdateCallbackCtx{this, item, added};
+    std::lock_guard<std::mutex> lock( m_pendingUpdatesLock );
+    m_pendingUpdates.push_back( std::move( update ) );
+    // Only wake the main loop up once for all the updates that pile up until
+    // it gets to flush them.
+    if ( m_flushScheduled == true )
+        return;
+    m_flushScheduled = true;
+    auto ctx = new MainLoopCallbackCtx{ this };
     ecore_main_loop_thread_safe_call_async([](void* data) {
-        std::unique_ptr<FileUpdateCallbackCtx> ctx( reinterpret_cast<FileUpdateCallbackCtx*>(data) );
+        std::unique_ptr<MainLoopCallbackCtx> ctx( reinterpret_cast<MainLoopCallbackCtx*>(data) );
         auto ml = ctx->wml.lock();
         if ( ml == nullptr )
             return;
-        for ( auto& p : ctx->ml->m_onItemUpdatedCb )
+        ctx->ml->flushUpdates();
+    }, ctx);
+}
+
+void
+media_library::flushUpdates()
+{
+    std::vector<PendingUpdate> updates;
+    {
+        std::lock_guard<std::mutex> lock( m_pendingUpdatesLock );
+        std::swap( updates, m_pendingUpdates );
+        m_flushScheduled = false;
+    }
+    // Consecutive updates of the same kind are sent as a single batch. Batches
+    // are sent in order, so that a removal can't overtake the matching addition
+    std::vector<const library_item*> items;
+    std::vector<int64_t> removedIds;
+    auto flushBatch = [this, &items, &removedIds]( const PendingUpdate& u ) {
+        if ( u.kind == PendingUpdate::Kind::Removed )
         {
-            if ( p.first( p.second, reinterpret_cast<library_item*>(ctx->item.get()), ctx->added ) == true )
-                break;
+            for ( auto& p : m_onItemsRemovedCb )
+                p.first( p.second, u.type, removedIds.data(), removedIds.size() );
+            removedIds.clear();
+            return;
         }
-    }, ctx);
+        for ( auto& p : m_onItemsUpdatedCb )
+            p.first( p.second, items.data(), items.size(), u.kind == PendingUpdate::Kind::Added );
+        items.clear();
+    };
+    for ( auto it = begin( updates ); it != end( updates ); ++it )
+    {
+        const auto& u = *it;
+        if ( u.kind == PendingUpdate::Kind::Removed )
+            removedIds.push_back( u.id );
+        else
+        {
+            for ( auto& p : m_onItemUpdatedCb )
+            {
+                if ( p.first( p.second, u.item.get(), u.kind == PendingUpdate::Kind::Added ) == true )
+                    break;
+            }
+            items.push_back( u.item.get() );
+        }
+        auto next = it + 1;
+        if ( next == end( updates ) || next->kind != u.kind || next->type != u.type )
+            flushBatch( u );
+    }
 }
 
 void
@@ -135,10 +424,28 @@ media_library::onReloadCompleted( const std::string& entryPoint )
         LOGI( "Media library reload completed" );
     else
         LOGI( "Media library folder %s reload completed", entryPoint.c_str() );
-    for (auto &p : m_onChangeCb)
-    {
-        ecore_main_loop_thread_safe_call_async( p.first, p.second );
-    }
+    notifyChanged();
+    // Media might have been removed along with their artwork
+    executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [this]() {
+        collectArtwork();
+    });
+}
+
+void
+media_library::notifyChanged()
+{
+    // The callbacks are looked up once on the main loop, so that a list
+    // that unregisters in the meantime isn't called
+    auto ctx = new MainLoopCallbackCtx{ this };
+    ecore_main_loop_thread_safe_call_async([](void* data) {
+        std::unique_ptr<MainLoopCallbackCtx> ctx( reinterpret_cast<MainLoopCallbackCtx*>(data) );
+        auto ml = ctx->wml.lock();
+        if ( ml == nullptr )
+            return;
+        auto callbacks = ctx->ml->m_onChangeCb;
+        for ( auto& p : callbacks )
+            p.first( p.second );
+    }, ctx);
 }
 
 void
@@ -166,7 +473,7 @@ media_library::unregisterOnChange(media_library_file_list_changed_cb cb, void* c
     auto ite = end(m_onChangeCb);
     for (auto it = begin(m_onChangeCb); it != ite; ++it)
     {
-        if ((*it).first == cb && (*it).second == cb)
+        if ((*it).first == cb && (*it).second == cbUserData)
         {
             m_onChangeCb.erase(it);
             return;
@@ -186,7 +493,7 @@ media_library::unregisterOnItemUpdated(media_library_item_updated_cb cb, void* u
     auto ite = end(m_onItemUpdatedCb);
     for (auto it = begin(m_onItemUpdatedCb); it != ite; ++it)
     {
-        if ((*it).first == cb && (*it).second == cb)
+        if ((*it).first == cb && (*it).second == userData)
         {
             m_onItemUpdatedCb.erase(it);
             return;
@@ -194,12 +501,69 @@ media_library::unregisterOnItemUpdated(media_library_item_updated_cb cb, void* u
     }
 }
 
+void
+media_library::registerOnItemsUpdated(media_library_items_updated_cb cb, void* userData)
+{
+    m_onItemsUpdatedCb.emplace_back( cb, userData );
+}
+
+void
+media_library::unregisterOnItemsUpdated(media_library_items_updated_cb cb, void* userData)
+{
+    auto ite = end(m_onItemsUpdatedCb);
+    for (auto it = begin(m_onItemsUpdatedCb); it != ite; ++it)
+    {
+        if ((*it).first == cb && (*it).second == userData)
+        {
+            m_onItemsUpdatedCb.erase(it);
+            return;
+        }
+    }
+}
+
+void
+media_library::registerOnItemsRemoved(media_library_items_removed_cb cb, void* userData)
+{
+    m_onItemsRemovedCb.emplace_back( cb, userData );
+}
+
+void
+media_library::unregisterOnItemsRemoved(media_library_items_removed_cb cb, void* userData)
+{
+    auto ite = end(m_onItemsRemovedCb);
+    for (auto it = begin(m_onItemsRemovedCb); it != ite; ++it)
+    {
+        if ((*it).first == cb && (*it).second == userData)
+        {
+            m_onItemsRemovedCb.erase(it);
+            return;
+        }
+    }
+}
+
 void media_library::onTracksAdded( std::vector<AlbumTrackPtr> tracks )
 {
+    // The track count & duration of the albums these tracks belong to changed.
+    std::vector<int64_t> albumIds;
+    for ( const auto& t : tracks )
+    {
+        auto id = t->albumId();
+        if ( std::find( begin( albumIds ), end( albumIds ), id ) == end( albumIds ) )
+            albumIds.push_back( id );
+    }
+    for ( auto id : albumIds )
+    {
+        auto album = ml->album( id );
+        if ( album != nullptr )
+            sendItemUpdate( reinterpret_cast<library_item*>( albumToAlbumItem( album ) ), false );
+    }
 }
 
-void media_library::onTracksDeleted( std::vector<int64_t> trackIds )
+void media_library::onTracksDeleted( std::vector<int64_t> )
 {
+    // Nothing to do: the corresponding media are reported through
+    // onMediaDeleted, which also drops them from the search index, and the
+    // albums through onAlbumsModified/Deleted
 }
 
 void media_library::registerProgressCb( media_library_scan_progress_cb pf_progress, void* p_data )
@@ -247,10 +611,19 @@ media_library_start(media_library* p_media_library)
         LOGE("Failed to create snapshot directory: %s", strerror(errno));
         return false;
     }
+    ArtworkStore::open( snapshotPath );
     p_media_library->logger.reset( new TizenLogger );
     p_media_library->ml->setVerbosity( LogLevel::Info );
     p_media_library->ml->setLogger( p_media_library->logger.get() );
-    return p_media_library->ml->initialize( appData + "vlc.db", snapshotPath, p_media_library );
+    if ( p_media_library->ml->initialize( appData + "vlc.db", snapshotPath, p_media_library ) == false )
+        return false;
+    p_media_library->executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [p_media_library]() {
+        p_media_library->buildSearchIndex();
+    });
+    p_media_library->executor.schedule( ML_QUERY_PRIORITY_BACKGROUND, [p_media_library]() {
+        p_media_library->generateMissingArtwork();
+    });
+    return true;
 }
 
 void
@@ -265,142 +638,249 @@ media_library_discover( const media_library* p_ml, const char* psz_location )
     p_ml->ml->discover( psz_location );
 }
 
+// Size of the first page of a list query. It only needs to fill a screen.
+static const unsigned int ML_FIRST_PAGE_SIZE = 20;
+// Size of the following pages.
+static const unsigned int ML_PAGE_SIZE = 200;
+
 template <typename SourceFunc, typename ConvertorFunc>
 struct ml_callback_context
 {
-    ml_callback_context( media_library_list_cb c, void* p_user_data, SourceFunc s, ConvertorFunc conv )
-        : cb(c), list(nullptr), p_data(p_user_data)
-          , source(s), convertor(conv){}
+    ml_callback_context( media_library_list_cb c, void* p_user_data, media_library_query* q,
+                         IMediaLibrary* m, const media_library_sort* p_sort, SourceFunc s, ConvertorFunc conv )
+        : cb(c), p_data(p_user_data), query(q), ml(m)
+          , source(s), convertor(conv)
+    {
+        sort.i_key = p_sort != nullptr ? p_sort->i_key : ML_SORT_DEFAULT;
+        sort.b_descending = p_sort != nullptr ? p_sort->b_descending : false;
+    }
     media_library_list_cb cb;
-    Eina_List* list;
     void* p_data;
+    media_library_query* query;
+    IMediaLibrary* ml;
+    media_library_sort sort;
     SourceFunc source;
     ConvertorFunc convertor;
 };
 
-template <typename SourceFunc, typename ConvertorFunc>
-void
-intermediate_list_callback( void* p_data )
+struct ml_page_context
+{
+    ml_page_context( media_library_list_cb c, media_library_query* q, Eina_List* l, bool last, void* p_user_data )
+        : cb(c), query(q), list(l), b_last(last), p_data(p_user_data){}
+    media_library_list_cb cb;
+    media_library_query* query;
+    Eina_List* list;
+    bool b_last;
+    void* p_data;
+};
+
+static void
+intermediate_page_callback( void* p_data )
+{
+    std::unique_ptr<ml_page_context> page( reinterpret_cast<ml_page_context*>( p_data ) );
+    if ( page->query->cancelled == false )
+        page->cb( page->list, page->b_last, page->p_data );
+    else
+    {
+        void* p_item;
+        EINA_LIST_FREE( page->list, p_item )
+            library_item_destroy( reinterpret_cast<library_item*>( p_item ) );
+    }
+    // The last page is always sent, even for a cancelled query, so this is
+    // the only place where the query can be released.
+    if ( page->b_last == true )
+        delete page->query;
+}
+
+static void
+media_library_send_page( media_library_list_cb cb, media_library_query* query, Eina_List* list, bool b_last, void* p_user_data )
+{
+    auto page = new ml_page_context( cb, query, list, b_last, p_user_data );
+    ecore_main_loop_thread_safe_call_async( intermediate_page_callback, page );
+}
+
+// Each page of media gets its own arena, so that the rows that get updated by
+// a later query, or the items queued for playback, don't keep the whole
+// result set alive
+template <typename ConvertorFunc>
+static void
+media_library_end_page( ConvertorFunc& )
+{
+}
+
+static void
+media_library_end_page( MediaItemConvertor& conv )
 {
-    auto ctx = reinterpret_cast<ml_callback_context<SourceFunc, ConvertorFunc>*>( p_data );
-    ctx->cb( ctx->list, ctx->p_data );
-    delete ctx;
+    conv.newArena();
 }
 
 template <typename SourceFunc, typename ConvertorFunc>
-static void media_library_common_getter(media_library_list_cb cb, void* p_user_data, SourceFunc source, ConvertorFunc conv)
+static media_library_query* media_library_common_getter(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data, SourceFunc source, ConvertorFunc conv)
 {
-    auto ctx = new ml_callback_context<SourceFunc, ConvertorFunc>( cb, p_user_data, source, conv );
+    auto query = new media_library_query;
+    auto ctx = std::make_shared<ml_callback_context<SourceFunc, ConvertorFunc>>( cb, p_user_data, query, p_ml->ml.get(), p_sort, source, conv );
 
-    ecore_thread_run( [](void* data, Ecore_Thread* ) {
-        auto ctx = reinterpret_cast<ml_callback_context<SourceFunc, ConvertorFunc>*>( data );
-        auto items = ctx->source();
+    // A query that can't run anymore won't deliver any page, so it has to be
+    // released here
+    auto cancel = [query]() { delete query; };
+    p_ml->executor.schedule( i_priority, [ctx]() {
         Eina_List *list = nullptr;
+        if ( ctx->query->cancelled == true )
+        {
+            media_library_send_page( ctx->cb, ctx->query, list, true, ctx->p_data );
+            return;
+        }
+        // The media library lists have no offset or count, only the
+        // conversion can be split in pages
+        auto items = ctx->source();
+        // The whole result set has to be sorted before the first page is sent
+        if ( ctx->sort.i_key != ML_SORT_DEFAULT )
+            sortItems( items, ctx->sort, ctx->ml );
+        else if ( ctx->sort.b_descending == true )
+            std::reverse( begin( items ), end( items ) );
+        unsigned int i_nb_items = 0;
+        unsigned int i_page_size = ML_FIRST_PAGE_SIZE;
         for ( auto& f : items )
         {
+            if ( ctx->query->cancelled == true )
+                break;
             auto elem = ctx->convertor( f );
             if ( elem == nullptr )
                 continue;
             list = eina_list_append( list, elem );
+            if ( ++i_nb_items < i_page_size )
+                continue;
+            // Don't flag a full page as the last one, even if it happens to
+            // be. An empty last page will follow.
+            media_library_send_page( ctx->cb, ctx->query, list, false, ctx->p_data );
+            media_library_end_page( ctx->convertor );
+            list = nullptr;
+            i_nb_items = 0;
+            i_page_size = ML_PAGE_SIZE;
         }
-        ctx->list = list;
-        ecore_main_loop_thread_safe_call_async( intermediate_list_callback<SourceFunc, ConvertorFunc>, ctx );
-    }, nullptr, nullptr, ctx );
+        media_library_send_page( ctx->cb, ctx->query, list, true, ctx->p_data );
+    }, cancel );
+    return query;
 }
 
 void
-media_library_get_audio_files( media_library* p_ml, media_library_list_cb cb, void* p_user_data )
+media_library_query_cancel( media_library_query* p_query )
+{
+    if ( p_query == nullptr )
+        return;
+    p_query->cancelled = true;
+}
+
+media_library_query*
+media_library_get_audio_files( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
 {
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
             [p_ml](){ return p_ml->ml->audioFiles(); },
-            fileToMediaItem);
+            MediaItemConvertor( p_ml->ml.get() ));
 }
 
-void
-media_library_get_video_files( media_library* p_ml, media_library_list_cb cb, void* p_user_data )
+media_library_query*
+media_library_get_video_files( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
 {
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
             [p_ml](){ return p_ml->ml->videoFiles(); },
-            fileToMediaItem);
+            MediaItemConvertor( p_ml->ml.get() ));
 }
 
-void
-media_library_get_albums(media_library* p_ml, media_library_list_cb cb, void* p_user_data)
+media_library_query*
+media_library_get_albums(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
 {
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
             [p_ml](){ return p_ml->ml->albums(); },
             albumToAlbumItem);
 }
 
-void
-media_library_get_artists( media_library* p_ml, media_library_list_cb cb, void* p_user_data )
+media_library_query*
+media_library_get_artists( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
 {
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
                 [p_ml](){ return p_ml->ml->artists(); },
                 artistToArtistItem);
 }
 
-void
-media_library_get_genres( media_library* p_ml, media_library_list_cb cb, void* p_user_data )
+media_library_query*
+media_library_get_genres( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
 {
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
             [p_ml](){ return p_ml->ml->genres();
         }, genreToGenreItem);
 }
 
 
-void
-media_library_get_artist_albums( media_library* p_ml, unsigned int i_artist_id, media_library_list_cb cb, void* p_user_data )
+media_library_query*
+media_library_get_artist_albums( media_library* p_ml, unsigned int i_artist_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
 {
     ArtistPtr artist = p_ml->ml->artist( i_artist_id );
     if (artist == nullptr)
     {
         LOGE("Can't find artist %d", i_artist_id);
-        return;
+        return nullptr;
     }
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
                 [artist](){ return artist->albums(); },
                 &albumToAlbumItem);
 }
 
-void
-media_library_get_album_songs(media_library* p_ml, unsigned int i_album_id, media_library_list_cb cb, void* p_user_data)
+media_library_query*
+media_library_get_album_songs(media_library* p_ml, unsigned int i_album_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
 {
     auto album = p_ml->ml->album(i_album_id);
     if (album == nullptr)
     {
         LOGE("Can't find album #%d", i_album_id);
-        return;
+        return nullptr;
     }
-    media_library_common_getter(cb, p_user_data,
+    // The media library already lists the tracks by disc and track number
+    media_library_sort sort = { ML_SORT_DEFAULT, false };
+    if ( p_sort != nullptr && p_sort->i_key != ML_SORT_TRACK_NUMBER )
+        sort = *p_sort;
+    else if ( p_sort != nullptr )
+        sort.b_descending = p_sort->b_descending;
+    return media_library_common_getter(p_ml, &sort, i_priority, cb, p_user_data,
             [album](){ return album->tracks(); },
-            fileToMediaItem);
+            MediaItemConvertor( p_ml->ml.get() ));
 }
 
-void
-media_library_get_artist_songs(media_library* p_ml, unsigned int i_artist_id, media_library_list_cb cb, void* p_user_data)
+media_library_query*
+media_library_get_artist_songs(media_library* p_ml, unsigned int i_artist_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
 {
     ArtistPtr artist = p_ml->ml->artist(i_artist_id);
     if (artist == nullptr)
     {
         LOGE("Can't find artist %u", i_artist_id);
-        return;
+        return nullptr;
     }
-    media_library_common_getter(cb, p_user_data,
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data,
                 [artist](){ return artist->media(); },
-                &fileToMediaItem);
+                MediaItemConvertor( p_ml->ml.get() ));
 }
 
-void
-media_library_get_genres_songs(media_library* p_ml, unsigned int i_genre_id, media_library_list_cb cb, void* p_user_data)
+media_library_query*
+media_library_get_genres_songs(media_library* p_ml, unsigned int i_genre_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
 {
     GenrePtr genre = p_ml->ml->genre(i_genre_id);
     if ( genre == nullptr )
     {
         LOGE("Can't find genre %u", i_genre_id);
-        return;
+        return nullptr;
     }
-    media_library_common_getter(cb, p_user_data, [genre]{ return genre->tracks(); }, &fileToMediaItem);
+    return media_library_common_getter(p_ml, p_sort, i_priority, cb, p_user_data, [genre]{ return genre->tracks(); },
+            MediaItemConvertor( p_ml->ml.get() ));
+}
+
+media_library_query*
+media_library_search( media_library* p_ml, const char* psz_pattern, enum MEDIA_ITEM_TYPE i_type, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
+{
+    std::string pattern( psz_pattern );
+    // Keep the results ranked
+    return media_library_common_getter(p_ml, nullptr, i_priority, cb, p_user_data,
+            [p_ml, pattern, i_type](){ return p_ml->search( pattern, i_type ); },
+            MediaItemConvertor( p_ml->ml.get() ));
 }
 
 void
@@ -427,6 +907,30 @@ media_library_unregister_item_updated(media_library* ml, media_library_item_upda
     ml->unregisterOnItemUpdated(cb, p_data);
 }
 
+void
+media_library_register_items_updated(media_library* ml, media_library_items_updated_cb cb, void* p_data )
+{
+    ml->registerOnItemsUpdated(cb, p_data);
+}
+
+void
+media_library_unregister_items_updated(media_library* ml, media_library_items_updated_cb cb, void* p_data )
+{
+    ml->unregisterOnItemsUpdated(cb, p_data);
+}
+
+void
+media_library_register_items_removed(media_library* ml, media_library_items_removed_cb cb, void* p_data )
+{
+    ml->registerOnItemsRemoved(cb, p_data);
+}
+
+void
+media_library_unregister_items_removed(media_library* ml, media_library_items_removed_cb cb, void* p_data )
+{
+    ml->unregisterOnItemsRemoved(cb, p_data);
+}
+
 void
 media_library_register_progress_cb( media_library* ml, media_library_scan_progress_cb pf_progress, void* p_data )
 {
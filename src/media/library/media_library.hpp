@@ -38,7 +38,60 @@ extern "C"
 #endif
 
 typedef void (*media_library_file_list_changed_cb)( void* p_user_data );
-typedef void (*media_library_list_cb)( Eina_List*, void *p_user_data );
+/**
+ * Handle on a running list query.
+ * It remains valid until the last page of the query has been delivered, or
+ * until the query is cancelled, whichever comes first.
+ */
+typedef struct media_library_query media_library_query;
+
+/**
+ * Queries are run by a dedicated set of workers. Queries for the list being
+ * displayed go first, then the ones for lists that aren't on screen, and
+ * background work only runs when no list query is waiting. Speculative and
+ * background work never occupy all the workers.
+ */
+typedef enum media_library_query_priority
+{
+    ML_QUERY_PRIORITY_VISIBLE,
+    ML_QUERY_PRIORITY_SPECULATIVE,
+    ML_QUERY_PRIORITY_BACKGROUND,
+    ML_QUERY_PRIORITY_COUNT
+} media_library_query_priority;
+
+/**
+ * Sorting criteria of list queries.
+ * Keys that don't apply to the listed items fall back to sorting by title
+ * (or name). Sorting is done by the query workers, before the first page is
+ * delivered.
+ */
+typedef enum media_library_sort_key
+{
+    ML_SORT_DEFAULT,            /* Whatever order the media library uses */
+    ML_SORT_TITLE,
+    ML_SORT_ARTIST,
+    ML_SORT_DURATION,
+    ML_SORT_INSERTION_DATE,
+    ML_SORT_RELEASE_YEAR,
+    ML_SORT_TRACK_NUMBER,
+} media_library_sort_key;
+
+typedef struct media_library_sort
+{
+    media_library_sort_key i_key;
+    bool b_descending;
+} media_library_sort;
+
+/**
+ * List queries are delivered page by page, so that views can start displaying
+ * results before the whole query has been converted. The first page is kept
+ * small enough to fill a screen, the following ones are bigger.
+ * The media library can't fetch a range of a list: the first page still waits
+ * for the whole result set to be read, and sorted.
+ * b_last is true for the final page of a query, which can be empty.
+ * This callback is guaranteed to be called from the main loop.
+ */
+typedef void (*media_library_list_cb)( Eina_List*, bool b_last, void *p_user_data );
 /**
  * If the callback handles the item update, it is expected to return true to
  * avoid calling potential other recipients that wouldn't have the file we're
@@ -46,6 +99,21 @@ typedef void (*media_library_list_cb)( Eina_List*, void *p_user_data );
  * There is no warranty about which thread will call this callback.
  */
 typedef bool (*media_library_item_updated_cb)( void *p_user_data, const library_item* p_item, bool b_new );
+/**
+ * Batched version of media_library_item_updated_cb.
+ * Updates are coalesced on the media library thread and delivered at most once
+ * per main loop iteration, new items first. The items are owned by the media
+ * library and only valid for the duration of the call.
+ * This callback is guaranteed to be called from the main loop.
+ */
+typedef void (*media_library_items_updated_cb)( void *p_user_data, const library_item* const* pp_items, unsigned int i_nb_items, bool b_new );
+/**
+ * Called when items of the given type have been removed from the media
+ * library. Removals are delivered along with the updates, in the order they
+ * happened.
+ * This callback is guaranteed to be called from the main loop.
+ */
+typedef void (*media_library_items_removed_cb)( void *p_user_data, library_item_type i_type, const int64_t* pi_ids, unsigned int i_nb_ids );
 
 typedef void (*media_library_scan_progress_cb)( void*, uint8_t );
 
@@ -55,38 +123,58 @@ media_library_create(application* p_app);
 bool
 media_library_start(media_library* p_media_library);
 
+/**
+ * Queries that haven't started yet are dropped without calling their
+ * callbacks, and their handles become invalid.
+ */
 void
 media_library_delete(media_library* p_media_library);
 
 void
 media_library_discover( const media_library* p_ml, const char* psz_location );
 
+/**
+ * Cancels a list query. The remaining pages are dropped and the list callback
+ * won't be called anymore. The query handle must not be used afterward.
+ * Must be called from the main loop.
+ */
 void
-media_library_get_video_files( media_library* p_ml, media_library_list_cb cb, void* p_user_data );
+media_library_query_cancel( media_library_query* p_query );
 
-void
-media_library_get_audio_files( media_library* p_ml, media_library_list_cb cb, void* p_user_data );
+media_library_query*
+media_library_get_video_files( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
-void
-media_library_get_artist_albums( media_library* p_ml, unsigned int i_artist_id, media_library_list_cb cb, void* p_user_data );
+media_library_query*
+media_library_get_audio_files( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
-void
-media_library_get_albums( media_library* p_ml, media_library_list_cb cb, void* p_user_data );
+media_library_query*
+media_library_get_artist_albums( media_library* p_ml, unsigned int i_artist_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
-void
-media_library_get_artists( media_library* p_ml, media_library_list_cb cb, void* p_user_data );
+media_library_query*
+media_library_get_albums( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
-void
-media_library_get_genres( media_library* p_ml, media_library_list_cb cb, void* p_user_data );
+media_library_query*
+media_library_get_artists( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
-void
-media_library_get_album_songs(media_library* p_ml, unsigned int i_album_id, media_library_list_cb cb, void* p_user_data);
+media_library_query*
+media_library_get_genres( media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
-void
-media_library_get_artist_songs(media_library* p_ml, unsigned int i_artist_id, media_library_list_cb cb, void* p_user_data);
+media_library_query*
+media_library_get_album_songs(media_library* p_ml, unsigned int i_album_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data);
 
-void
-media_library_get_genres_songs(media_library* p_ml, unsigned int i_genre_id, media_library_list_cb cb, void* p_user_data);
+media_library_query*
+media_library_get_artist_songs(media_library* p_ml, unsigned int i_artist_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data);
+
+media_library_query*
+media_library_get_genres_songs(media_library* p_ml, unsigned int i_genre_id, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data);
+
+/**
+ * Lists the media matching the pattern, best matches first.
+ * Every word of the pattern has to match the title, artist, album or genre.
+ * MEDIA_ITEM_TYPE_UNKNOWN matches all media types.
+ */
+media_library_query*
+media_library_search( media_library* p_ml, const char* psz_pattern, enum MEDIA_ITEM_TYPE i_type, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data );
 
 void
 media_library_register_on_change(media_library* ml, media_library_file_list_changed_cb cb, void* p_data);
@@ -100,6 +188,18 @@ media_library_register_item_updated(media_library* ml, media_library_item_update
 void
 media_library_unregister_item_updated(media_library* ml, media_library_item_updated_cb cb, void* p_data );
 
+void
+media_library_register_items_updated(media_library* ml, media_library_items_updated_cb cb, void* p_data );
+
+void
+media_library_unregister_items_updated(media_library* ml, media_library_items_updated_cb cb, void* p_data );
+
+void
+media_library_register_items_removed(media_library* ml, media_library_items_removed_cb cb, void* p_data );
+
+void
+media_library_unregister_items_removed(media_library* ml, media_library_items_removed_cb cb, void* p_data );
+
 void
 media_library_register_progress_cb( media_library* ml, media_library_scan_progress_cb pf_progress, void* p_data );
 
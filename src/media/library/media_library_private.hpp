@@ -24,18 +24,73 @@
  * compatibility with the Store
  *****************************************************************************/
 
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "IAlbum.h"
 #include "IMedia.h"
 #include "ILogger.h"
 #include "media_library.hpp"
+#include "query_executor.hpp"
+#include "search_index.hpp"
 #include "media/media_item.h"
 #include "media/album_item.h"
 #include "media/artist_item.h"
 #include "media/genre_item.h"
 
-media_item* fileToMediaItem( MediaPtr file );
+/*
+ * Converts a whole result set of media.
+ * Albums, artists and genres are shared by many tracks, so they are only
+ * fetched once per result set and looked up by id afterward. When a result set
+ * references enough of them, all albums, artists and genres are fetched at
+ * once.
+ * The converted items are allocated from an arena, shared by the copies of the
+ * convertor, until newArena() is called.
+ */
+class MediaItemConvertor
+{
+public:
+    explicit MediaItemConvertor( IMediaLibrary* ml );
+    media_item* operator()( MediaPtr media );
+    // Path of the snapshot or artwork of a media, if any
+    std::string artwork( MediaPtr media );
+    AlbumPtr album( AlbumTrackPtr track );
+    ArtistPtr artist( AlbumTrackPtr track );
+    GenrePtr genre( AlbumTrackPtr track );
+    // The following items get a new arena, so that the ones converted so
+    // far can be freed independently
+    void newArena();
+
+private:
+    bool prefetch();
+
+private:
+    IMediaLibrary* m_ml;
+    std::shared_ptr<media_item_arena> m_arena;
+    std::unordered_map<int64_t, AlbumPtr> m_albums;
+    std::unordered_map<int64_t, ArtistPtr> m_artists;
+    std::unordered_map<int64_t, GenrePtr> m_genres;
+    unsigned int m_nbMisses;
+    bool m_prefetched;
+};
+
+struct media_library_query
+{
+    media_library_query() : cancelled( false ) {}
+    // Set from the main loop, polled by the worker thread
+    std::atomic_bool cancelled;
+};
+
+void sortItems( std::vector<MediaPtr>& media, const media_library_sort& sort, IMediaLibrary* ml );
+void sortItems( std::vector<AlbumPtr>& albums, const media_library_sort& sort, IMediaLibrary* ml );
+void sortItems( std::vector<ArtistPtr>& artists, const media_library_sort& sort, IMediaLibrary* ml );
+void sortItems( std::vector<GenrePtr>& genres, const media_library_sort& sort, IMediaLibrary* ml );
+
+// Returns the path of a file:// URL
+std::string pathFromUrl( const std::string& url );
+
 album_item* albumToAlbumItem( AlbumPtr album );
 artist_item* artistToArtistItem( ArtistPtr album );
 genre_item* genreToGenreItem( GenrePtr genre );
@@ -67,7 +122,7 @@ struct media_library : public IMediaLibraryCb
 {
 public:
     media_library();
-    virtual ~media_library() = default;
+    virtual ~media_library();
 
     // IMediaLibraryCb
     virtual void onMediaAdded( std::vector<MediaPtr> media ) override;
@@ -99,28 +154,79 @@ public:
     void registerOnItemUpdated(media_library_item_updated_cb cb, void* userData);
     void unregisterOnItemUpdated(media_library_item_updated_cb cb, void* userData);
 
+    void registerOnItemsUpdated(media_library_items_updated_cb cb, void* userData);
+    void unregisterOnItemsUpdated(media_library_items_updated_cb cb, void* userData);
+
+    void registerOnItemsRemoved(media_library_items_removed_cb cb, void* userData);
+    void unregisterOnItemsRemoved(media_library_items_removed_cb cb, void* userData);
+
     void registerProgressCb( media_library_scan_progress_cb pf_progress, void* p_data );
 
+    std::vector<MediaPtr> search( const std::string& pattern, MEDIA_ITEM_TYPE type );
+    // Startup backfill, done by small background tasks that list queries can
+    // run in between
+    void buildSearchIndex();
+    void generateMissingArtwork();
+    void collectArtwork();
+
 public:
     // Logger needs to be before ml, since ml will take a raw pointer to the logger.
     // yes, it sucks, but unique_ptr is too restrictive, and shared_ptr is overkill.
     // I'll make up my mind someday, I promise.
     std::unique_ptr<TizenLogger> logger;
     std::shared_ptr<IMediaLibrary> ml;
+    // Stopped first thing on destruction, so that the tasks don't run on a
+    // partly destroyed media_library
+    QueryExecutor executor;
 
 private:
-    void sendFileUpdate( MediaPtr item, bool added );
+    struct PendingUpdate
+    {
+        enum class Kind
+        {
+            Added,
+            Modified,
+            Removed,
+        };
+        PendingUpdate(library_item* _item, bool _added)
+            : item(_item, library_item_destroy)
+            , kind(_added ? Kind::Added : Kind::Modified)
+            , type(_item->i_library_item_type)
+            , id(library_item_get_id(_item)) {}
+        PendingUpdate(library_item_type _type, int64_t _id)
+            : item(nullptr, library_item_destroy)
+            , kind(Kind::Removed)
+            , type(_type)
+            , id(_id) {}
+        // Removals only carry the type and ID of the removed item
+        std::unique_ptr<library_item, void(*)(library_item*)> item;
+        Kind kind;
+        library_item_type type;
+        int64_t id;
+    };
+
+    void indexMedia( const media_item* item );
+    void sendItemUpdate( library_item* item, bool added );
+    void sendItemsRemoved( library_item_type type, const std::vector<int64_t>& ids );
+    void queueUpdate( PendingUpdate update );
+    void flushUpdates();
+    void notifyChanged();
+    // Generates the missing artwork variants in the background, then sends
+    // the items again with their icon
+    void generateArtwork( std::vector<MediaPtr> media );
+    void generateArtwork( std::vector<AlbumPtr> albums );
+    void generateArtwork( std::vector<ArtistPtr> artists );
+    // Path of the artworks of all the library items
+    std::unordered_set<std::string> artworks();
 
 private:
-    struct FileUpdateCallbackCtx
+    struct MainLoopCallbackCtx
     {
-        FileUpdateCallbackCtx(media_library* _ml, media_item* _item, bool _added)
-            : ml(_ml), wml(ml->ml), item(_item, media_item_destroy), added(_added) {}
+        MainLoopCallbackCtx(media_library* _ml)
+            : ml(_ml), wml(ml->ml) {}
         media_library* ml;
-        std::weak_ptr<IMediaLibrary> wml;
-        std::unique_ptr<media_item, void(*)(media_item*)> item;
         // Used to monitor media_library's lifetime.
-        bool added;
+        std::weak_ptr<IMediaLibrary> wml;
     };
 
     struct ProgressUpdateCallbackCtx
@@ -139,6 +245,13 @@ private:
 private:
     std::vector<std::pair<media_library_file_list_changed_cb, void*>> m_onChangeCb;
     std::vector<std::pair<media_library_item_updated_cb, void*>> m_onItemUpdatedCb;
+    std::vector<std::pair<media_library_items_updated_cb, void*>> m_onItemsUpdatedCb;
+    std::vector<std::pair<media_library_items_removed_cb, void*>> m_onItemsRemovedCb;
+    // Updates waiting to be flushed to the main loop.
+    std::mutex m_pendingUpdatesLock;
+    std::vector<PendingUpdate> m_pendingUpdates;
+    bool m_flushScheduled;
     media_library_scan_progress_cb m_progressCb;
     void* m_progressData;
+    SearchIndex m_searchIndex;
 };
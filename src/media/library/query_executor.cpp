@@ -0,0 +1,176 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "query_executor.hpp"
+
+// Most of the time is spent in sqlite, which doesn't scale much further
+static const unsigned int ML_MAX_WORKERS = 4;
+#ifdef _DEBUG
+static const std::chrono::seconds ML_STATS_PERIOD( 30 );
+#endif
+
+QueryExecutor::QueryExecutor()
+    : m_stop( false )
+{
+    // Leave a core to the main loop, but keep a worker for the visible lane
+    // besides the one the other lanes can use
+    auto nbCores = std::thread::hardware_concurrency();
+    auto nbWorkers = nbCores > 1 ? nbCores - 1 : 1;
+    nbWorkers = std::max( std::min( nbWorkers, ML_MAX_WORKERS ), 2u );
+    LOGI( "Starting %u media library workers", nbWorkers );
+    for ( auto i = 0u; i < nbWorkers; ++i )
+        m_workers.emplace_back( &QueryExecutor::work, this );
+}
+
+QueryExecutor::~QueryExecutor()
+{
+    stop();
+}
+
+void
+QueryExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for ( auto& t : m_workers )
+        t.join();
+    m_workers.clear();
+    // No worker is left to pick the pending tasks, and schedule() doesn't
+    // queue anymore
+    for ( auto& lane : m_lanes )
+    {
+        for ( auto& task : lane.tasks )
+        {
+            if ( task.cancel != nullptr )
+                task.cancel();
+        }
+        lane.tasks.clear();
+    }
+}
+
+void
+QueryExecutor::schedule( media_library_query_priority priority, std::function<void()> task,
+                         std::function<void()> cancel )
+{
+    {
+        std::unique_lock<std::mutex> lock( m_lock );
+        if ( m_stop == true )
+        {
+            lock.unlock();
+            if ( cancel != nullptr )
+                cancel();
+            return;
+        }
+        auto& lane = m_lanes[priority];
+        lane.tasks.push_back( Task{ std::move( task ), std::move( cancel ) } );
+        lane.maxPending = std::max<unsigned int>( lane.maxPending, lane.tasks.size() );
+    }
+    // Notify everyone, since the woken up worker might not be allowed to run
+    // this lane.
+    m_cond.notify_all();
+}
+
+void
+QueryExecutor::logStats()
+{
+#ifdef _DEBUG
+    static const char* const names[ML_QUERY_PRIORITY_COUNT] = {
+        "visible", "speculative", "background"
+    };
+    auto now = std::chrono::steady_clock::now();
+    if ( now - m_lastStats < ML_STATS_PERIOD )
+        return;
+    m_lastStats = now;
+    for ( auto p = 0; p < ML_QUERY_PRIORITY_COUNT; ++p )
+    {
+        const auto& lane = m_lanes[p];
+        LOGD( "Query lane %s: %zu pending, %u running, %u max pending, %" PRIu64 " completed",
+              names[p], lane.tasks.size(), lane.nbRunning, lane.maxPending, lane.nbCompleted );
+    }
+#endif
+}
+
+bool
+QueryExecutor::canRun( media_library_query_priority priority ) const
+{
+    if ( m_lanes[priority].tasks.empty() == true )
+        return false;
+    if ( priority == ML_QUERY_PRIORITY_VISIBLE )
+        return true;
+    // Keep a worker available for the visible lane
+    auto nbRunning = 0u;
+    for ( auto p = ML_QUERY_PRIORITY_SPECULATIVE; p < ML_QUERY_PRIORITY_COUNT;
+          p = (media_library_query_priority)( p + 1 ) )
+        nbRunning += m_lanes[p].nbRunning;
+    return nbRunning + 1 < m_workers.size();
+}
+
+void
+QueryExecutor::work()
+{
+    std::unique_lock<std::mutex> lock( m_lock );
+    while ( true )
+    {
+        auto priority = ML_QUERY_PRIORITY_VISIBLE;
+        m_cond.wait( lock, [this, &priority]() {
+            if ( m_stop == true )
+                return true;
+            for ( auto p = 0; p < ML_QUERY_PRIORITY_COUNT; ++p )
+            {
+                if ( canRun( (media_library_query_priority)p ) == true )
+                {
+                    priority = (media_library_query_priority)p;
+                    return true;
+                }
+            }
+            return false;
+        });
+        // Pending tasks are cancelled by stop()
+        if ( m_stop == true )
+            return;
+        auto& lane = m_lanes[priority];
+        auto task = std::move( lane.tasks.front().run );
+        lane.tasks.pop_front();
+        lane.nbRunning++;
+        lock.unlock();
+        task();
+        lock.lock();
+        lane.nbRunning--;
+        lane.nbCompleted++;
+        logStats();
+        // A speculative or background slot might just have been freed
+        if ( priority != ML_QUERY_PRIORITY_VISIBLE )
+            m_cond.notify_all();
+    }
+}
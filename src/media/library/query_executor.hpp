@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#ifndef QUERY_EXECUTOR_HPP_
+# define QUERY_EXECUTOR_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "media_library.hpp"
+
+/*
+ * Runs media library queries on a fixed set of worker threads.
+ * Tasks are picked from the visible lane first, then the speculative one.
+ * Speculative and background tasks never occupy all the workers, so that a
+ * query for the list being looked at can always start right away.
+ * Tasks that haven't started when the executor stops are cancelled instead:
+ * their cancel function, if any, is called from the stopping thread.
+ * The depth of each lane is logged periodically in debug builds, while tasks
+ * run.
+ */
+class QueryExecutor
+{
+public:
+    QueryExecutor();
+    ~QueryExecutor();
+
+    void schedule( media_library_query_priority priority, std::function<void()> task,
+                   std::function<void()> cancel = nullptr );
+    // Waits for the running tasks, and cancels the pending ones
+    void stop();
+
+private:
+    void work();
+    bool canRun( media_library_query_priority priority ) const;
+    void logStats();
+
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        std::function<void()> cancel;
+    };
+
+    struct Lane
+    {
+        Lane() : nbRunning( 0 ), maxPending( 0 ), nbCompleted( 0 ) {}
+        std::deque<Task> tasks;
+        unsigned int nbRunning;
+        unsigned int maxPending;
+        uint64_t nbCompleted;
+    };
+
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    Lane m_lanes[ML_QUERY_PRIORITY_COUNT];
+    std::vector<std::thread> m_workers;
+    std::chrono::steady_clock::time_point m_lastStats;
+    bool m_stop;
+};
+
+#endif // QUERY_EXECUTOR_HPP_
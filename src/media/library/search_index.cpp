@@ -0,0 +1,305 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+#include "search_index.hpp"
+
+// Don't bother compacting small indexes
+static const size_t ML_SEARCH_MIN_COMPACT = 1024;
+
+static const unsigned int FieldWeights[SearchIndex::NbFields] = {
+    8, // Title
+    4, // Artist
+    3, // Album
+    1, // Genre
+};
+
+static inline uint32_t
+trigram( const std::string& str, size_t i )
+{
+    return (uint8_t)str[i] << 16 | (uint8_t)str[i + 1] << 8 | (uint8_t)str[i + 2];
+}
+
+static SearchIndex::PostingList
+intersect( const SearchIndex::PostingList& left, const SearchIndex::PostingList& right )
+{
+    SearchIndex::PostingList res;
+    std::set_intersection( begin( left ), end( left ), begin( right ), end( right ),
+                           std::back_inserter( res ) );
+    return res;
+}
+
+SearchIndex::SearchIndex()
+    : m_nbDead( 0 )
+{
+}
+
+std::string
+SearchIndex::normalize( const std::string& str )
+{
+    // Only ASCII is folded. Other characters are indexed as they are
+    std::string res;
+    res.reserve( str.size() );
+    for ( auto c : str )
+    {
+        if ( ( c & 0x80 ) == 0 )
+        {
+            auto uc = static_cast<unsigned char>( c );
+            c = isalnum( uc ) == 0 ? ' ' : static_cast<char>( tolower( uc ) );
+        }
+        if ( c == ' ' && ( res.empty() == true || res.back() == ' ' ) )
+            continue;
+        res.push_back( c );
+    }
+    if ( res.empty() == false && res.back() == ' ' )
+        res.pop_back();
+    return res;
+}
+
+std::vector<std::string>
+SearchIndex::split( const std::string& str )
+{
+    std::vector<std::string> words;
+    size_t start = 0;
+    while ( start < str.size() )
+    {
+        auto end = str.find( ' ', start );
+        if ( end == std::string::npos )
+            end = str.size();
+        if ( end > start )
+            words.emplace_back( str, start, end - start );
+        start = end + 1;
+    }
+    return words;
+}
+
+void
+SearchIndex::add( int64_t id, MEDIA_ITEM_TYPE type, const std::string (&fields)[NbFields] )
+{
+    std::lock_guard<std::mutex> lock( m_lock );
+    auto it = m_ids.find( id );
+    if ( it != end( m_ids ) )
+        kill( it->second );
+    insert( id, type, fields );
+    compactIfNeeded();
+}
+
+void
+SearchIndex::addIfMissing( int64_t id, MEDIA_ITEM_TYPE type, const std::string (&fields)[NbFields] )
+{
+    std::lock_guard<std::mutex> lock( m_lock );
+    if ( m_ids.find( id ) != end( m_ids ) )
+        return;
+    insert( id, type, fields );
+}
+
+void
+SearchIndex::remove( int64_t id )
+{
+    std::lock_guard<std::mutex> lock( m_lock );
+    auto it = m_ids.find( id );
+    if ( it == end( m_ids ) )
+        return;
+    kill( it->second );
+    m_ids.erase( it );
+    compactIfNeeded();
+}
+
+void
+SearchIndex::insert( int64_t id, MEDIA_ITEM_TYPE type, const std::string (&fields)[NbFields] )
+{
+    uint32_t docIdx = m_docs.size();
+    m_docs.emplace_back();
+    auto& doc = m_docs.back();
+    doc.id = id;
+    doc.type = type;
+    doc.alive = true;
+    for ( auto f = 0; f < NbFields; ++f )
+    {
+        doc.fields[f] = normalize( fields[f] );
+        const auto& str = doc.fields[f];
+        for ( size_t i = 0; i + 2 < str.size(); ++i )
+        {
+            auto& list = m_trigrams[trigram( str, i )];
+            if ( list.empty() == true || list.back() != docIdx )
+                list.push_back( docIdx );
+        }
+        for ( auto& w : split( str ) )
+        {
+            auto& list = m_words[w];
+            if ( list.empty() == true || list.back() != docIdx )
+                list.push_back( docIdx );
+        }
+    }
+    m_ids[id] = docIdx;
+}
+
+void
+SearchIndex::kill( uint32_t docIdx )
+{
+    auto& doc = m_docs[docIdx];
+    doc.alive = false;
+    for ( auto& f : doc.fields )
+        std::string().swap( f );
+    m_nbDead++;
+}
+
+void
+SearchIndex::compactIfNeeded()
+{
+    if ( m_nbDead >= ML_SEARCH_MIN_COMPACT && m_nbDead > m_ids.size() )
+        compact();
+}
+
+void
+SearchIndex::compact()
+{
+    LOGD( "Compacting search index (%zu dead documents)", m_nbDead );
+    std::vector<Document> docs;
+    std::swap( docs, m_docs );
+    m_ids.clear();
+    m_trigrams.clear();
+    m_words.clear();
+    m_nbDead = 0;
+    for ( const auto& d : docs )
+    {
+        if ( d.alive == true )
+            insert( d.id, d.type, d.fields );
+    }
+}
+
+SearchIndex::PostingList
+SearchIndex::candidates( const std::string& token ) const
+{
+    if ( token.size() >= 3 )
+    {
+        // Start from the smallest posting list, to keep the intersections cheap
+        std::vector<const PostingList*> lists;
+        for ( size_t i = 0; i + 2 < token.size(); ++i )
+        {
+            auto it = m_trigrams.find( trigram( token, i ) );
+            if ( it == end( m_trigrams ) )
+                return {};
+            lists.push_back( &it->second );
+        }
+        std::sort( begin( lists ), end( lists ), []( const PostingList* l, const PostingList* r ) {
+            return l->size() < r->size();
+        });
+        auto res = *lists[0];
+        for ( size_t i = 1; i < lists.size() && res.empty() == false; ++i )
+            res = intersect( res, *lists[i] );
+        return res;
+    }
+    PostingList res;
+    for ( auto it = m_words.lower_bound( token );
+          it != end( m_words ) && it->first.compare( 0, token.size(), token ) == 0; ++it )
+        res.insert( end( res ), begin( it->second ), end( it->second ) );
+    std::sort( begin( res ), end( res ) );
+    res.erase( std::unique( begin( res ), end( res ) ), end( res ) );
+    return res;
+}
+
+unsigned int
+SearchIndex::score( const Document& doc, const std::vector<std::string>& tokens ) const
+{
+    unsigned int total = 0;
+    for ( const auto& t : tokens )
+    {
+        unsigned int best = 0;
+        for ( auto f = 0; f < NbFields; ++f )
+        {
+            const auto& str = doc.fields[f];
+            auto pos = str.find( t );
+            if ( pos == std::string::npos )
+                continue;
+            // Favor matches at the start of the field, then at a word start
+            unsigned int s = FieldWeights[f];
+            if ( pos == 0 )
+                s *= 4;
+            else if ( str[pos - 1] == ' ' )
+                s *= 2;
+            // Favor exact field matches
+            if ( t.size() == str.size() )
+                s *= 2;
+            best = std::max( best, s );
+        }
+        // Trigrams can match tokens that aren't actually in the document
+        if ( best == 0 )
+            return 0;
+        total += best;
+    }
+    return total;
+}
+
+std::vector<int64_t>
+SearchIndex::search( const std::string& pattern, MEDIA_ITEM_TYPE type, size_t maxResults )
+{
+    auto tokens = split( normalize( pattern ) );
+    if ( tokens.empty() == true )
+        return {};
+
+    std::lock_guard<std::mutex> lock( m_lock );
+    auto docs = candidates( tokens[0] );
+    for ( size_t i = 1; i < tokens.size() && docs.empty() == false; ++i )
+        docs = intersect( docs, candidates( tokens[i] ) );
+
+    std::vector<std::pair<unsigned int, const Document*>> matches;
+    for ( auto idx : docs )
+    {
+        const auto& doc = m_docs[idx];
+        if ( doc.alive == false )
+            continue;
+        if ( type != MEDIA_ITEM_TYPE_UNKNOWN && doc.type != type )
+            continue;
+        auto s = score( doc, tokens );
+        if ( s > 0 )
+            matches.emplace_back( s, &doc );
+    }
+    auto cmp = []( const std::pair<unsigned int, const Document*>& l,
+                   const std::pair<unsigned int, const Document*>& r ) {
+        if ( l.first != r.first )
+            return l.first > r.first;
+        return l.second->fields[Title] < r.second->fields[Title];
+    };
+    auto last = end( matches );
+    if ( matches.size() > maxResults )
+    {
+        last = begin( matches ) + maxResults;
+        std::partial_sort( begin( matches ), last, end( matches ), cmp );
+    }
+    else
+        std::sort( begin( matches ), end( matches ), cmp );
+
+    std::vector<int64_t> res;
+    for ( auto it = begin( matches ); it != last; ++it )
+        res.push_back( it->second->id );
+    return res;
+}
@@ -0,0 +1,102 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#ifndef SEARCH_INDEX_HPP_
+# define SEARCH_INDEX_HPP_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "media/media_item.h"
+
+/*
+ * In memory full text index over the media titles, artists, albums & genres.
+ * Patterns of 3 characters or more are looked up through trigrams, so they can
+ * match anywhere in a field. Shorter ones are matched against word prefixes.
+ * Removed or updated documents are only flagged as dead, and the index is
+ * compacted once they outnumber the live ones.
+ */
+class SearchIndex
+{
+public:
+    enum Field
+    {
+        Title,
+        Artist,
+        Album,
+        Genre,
+        NbFields
+    };
+
+    // Sorted document indexes
+    typedef std::vector<uint32_t> PostingList;
+
+    SearchIndex();
+
+    // Replaces the document for this media, if any
+    void add( int64_t id, MEDIA_ITEM_TYPE type, const std::string (&fields)[NbFields] );
+    // Same as add, but leaves an already indexed media untouched
+    void addIfMissing( int64_t id, MEDIA_ITEM_TYPE type, const std::string (&fields)[NbFields] );
+    void remove( int64_t id );
+    // Returns the ID of the best matches, best first.
+    // MEDIA_ITEM_TYPE_UNKNOWN matches any type.
+    std::vector<int64_t> search( const std::string& pattern, MEDIA_ITEM_TYPE type, size_t maxResults );
+
+private:
+    struct Document
+    {
+        int64_t id;
+        MEDIA_ITEM_TYPE type;
+        std::string fields[NbFields];
+        bool alive;
+    };
+
+    void insert( int64_t id, MEDIA_ITEM_TYPE type, const std::string (&fields)[NbFields] );
+    void kill( uint32_t docIdx );
+    void compactIfNeeded();
+    void compact();
+    PostingList candidates( const std::string& token ) const;
+    unsigned int score( const Document& doc, const std::vector<std::string>& tokens ) const;
+
+    static std::string normalize( const std::string& str );
+    static std::vector<std::string> split( const std::string& str );
+
+private:
+    std::mutex m_lock;
+    std::vector<Document> m_docs;
+    // Media ID -> index of its live document
+    std::unordered_map<int64_t, uint32_t> m_ids;
+    // Posting lists are sorted, since documents are only ever appended
+    std::unordered_map<uint32_t, PostingList> m_trigrams;
+    std::map<std::string, PostingList> m_words;
+    size_t m_nbDead;
+};
+
+#endif // SEARCH_INDEX_HPP_
@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "media_library_private.hpp"
+#include "IAlbum.h"
+#include "IAlbumTrack.h"
+#include "IArtist.h"
+#include "IGenre.h"
+
+namespace
+{
+
+struct SortKey
+{
+    SortKey() : num( 0 ), subNum( 0 ) {}
+    int64_t num;
+    std::string str;
+    // Orders the items which share the same string, such as the tracks of an
+    // album
+    int64_t subNum;
+    // Orders the items which share the same key, usually by title
+    std::string tieBreak;
+
+    bool operator<( const SortKey& k ) const
+    {
+        if ( num != k.num )
+            return num < k.num;
+        if ( str != k.str )
+            return str < k.str;
+        if ( subNum != k.subNum )
+            return subNum < k.subNum;
+        return tieBreak < k.tieBreak;
+    }
+};
+
+std::string
+lower( const std::string& str )
+{
+    std::string res( str );
+    std::transform( begin( res ), end( res ), begin( res ), []( char c ) {
+        return ( c & 0x80 ) == 0 ? tolower( c ) : c;
+    });
+    return res;
+}
+
+// Computes every key once, instead of once per comparison
+template <typename T, typename KeyFunc>
+void
+sortBy( std::vector<T>& items, bool descending, KeyFunc keyFunc )
+{
+    std::vector<std::pair<SortKey, T>> keyed;
+    keyed.reserve( items.size() );
+    for ( auto& i : items )
+        keyed.emplace_back( keyFunc( i ), std::move( i ) );
+    std::stable_sort( begin( keyed ), end( keyed ),
+                      [descending]( const std::pair<SortKey, T>& l, const std::pair<SortKey, T>& r ) {
+        return descending == true ? r.first < l.first : l.first < r.first;
+    });
+    for ( size_t i = 0; i < keyed.size(); ++i )
+        items[i] = std::move( keyed[i].second );
+}
+
+}
+
+void
+sortItems( std::vector<MediaPtr>& media, const media_library_sort& sort, IMediaLibrary* ml )
+{
+    if ( media.size() < 2 )
+        return;
+    // Albums and artists are shared by many tracks, the convertor only
+    // fetches them once
+    MediaItemConvertor conv( ml );
+    sortBy( media, sort.b_descending, [&sort, &conv]( const MediaPtr& m ) {
+        SortKey k;
+        k.tieBreak = lower( m->title() );
+        switch ( sort.i_key )
+        {
+        case ML_SORT_DEFAULT:
+        case ML_SORT_TITLE:
+            break;
+        case ML_SORT_ARTIST:
+        {
+            auto track = m->albumTrack();
+            auto artist = track != nullptr ? conv.artist( track ) : nullptr;
+            if ( artist != nullptr )
+                k.str = lower( artist->name() );
+            break;
+        }
+        case ML_SORT_DURATION:
+            k.num = m->duration();
+            break;
+        case ML_SORT_INSERTION_DATE:
+            k.num = m->insertionDate();
+            break;
+        case ML_SORT_RELEASE_YEAR:
+            k.num = m->releaseDate();
+            break;
+        case ML_SORT_TRACK_NUMBER:
+        {
+            // Track numbers are only meaningful within an album: the tracks
+            // are grouped by album, then ordered by disc and track number
+            auto track = m->albumTrack();
+            if ( track == nullptr )
+                break;
+            auto album = conv.album( track );
+            if ( album != nullptr )
+                k.str = lower( album->title() );
+            k.subNum = ( track->albumId() << 32 ) |
+                       ( std::min<int64_t>( track->discNumber(), 0xFFFF ) << 16 ) |
+                       std::min<int64_t>( track->trackNumber(), 0xFFFF );
+            break;
+        }
+        }
+        return k;
+    });
+}
+
+void
+sortItems( std::vector<AlbumPtr>& albums, const media_library_sort& sort, IMediaLibrary* )
+{
+    sortBy( albums, sort.b_descending, [&sort]( const AlbumPtr& a ) {
+        SortKey k;
+        k.tieBreak = lower( a->title() );
+        switch ( sort.i_key )
+        {
+        case ML_SORT_ARTIST:
+        {
+            auto artist = a->albumArtist();
+            if ( artist != nullptr )
+                k.str = lower( artist->name() );
+            break;
+        }
+        case ML_SORT_DURATION:
+            k.num = a->duration();
+            break;
+        case ML_SORT_RELEASE_YEAR:
+            k.num = a->releaseYear();
+            break;
+        default:
+            // Other keys don't apply to albums: sort by title
+            break;
+        }
+        return k;
+    });
+}
+
+void
+sortItems( std::vector<ArtistPtr>& artists, const media_library_sort& sort, IMediaLibrary* )
+{
+    // Artists can only be sorted by name
+    sortBy( artists, sort.b_descending, []( const ArtistPtr& a ) {
+        SortKey k;
+        k.tieBreak = lower( a->name() );
+        return k;
+    });
+}
+
+void
+sortItems( std::vector<GenrePtr>& genres, const media_library_sort& sort, IMediaLibrary* )
+{
+    // Genres can only be sorted by name
+    sortBy( genres, sort.b_descending, []( const GenrePtr& g ) {
+        SortKey k;
+        k.tieBreak = lower( g->name() );
+        return k;
+    });
+}
@@ -25,6 +25,137 @@
 #include "common.h"
 #include "media_item.h"
 
+#include <Eina.h>
+
+/* Chunks start small, since many arenas only hold a few items, and grow with
+ * the result set */
+#define ARENA_MIN_CHUNK_SIZE 1024
+#define ARENA_MAX_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+typedef struct arena_chunk
+{
+    struct arena_chunk *p_next;
+    size_t i_size;
+    size_t i_used;
+    /* Followed by i_size bytes */
+} arena_chunk;
+
+struct media_item_arena
+{
+    int i_refs;
+    arena_chunk *p_chunks;
+    size_t i_next_chunk_size;
+};
+
+media_item_arena *
+media_item_arena_create(void)
+{
+    media_item_arena *p_arena = calloc(1, sizeof(*p_arena));
+    if (!p_arena)
+        return NULL;
+    p_arena->i_refs = 1;
+    p_arena->i_next_chunk_size = ARENA_MIN_CHUNK_SIZE;
+    return p_arena;
+}
+
+static void
+media_item_arena_hold(media_item_arena *p_arena)
+{
+    __atomic_add_fetch(&p_arena->i_refs, 1, __ATOMIC_RELAXED);
+}
+
+void
+media_item_arena_release(media_item_arena *p_arena)
+{
+    if (p_arena == NULL)
+        return;
+    /* Items are released from the main loop while their arena creator may
+     * still be running on a media library thread */
+    if (__atomic_sub_fetch(&p_arena->i_refs, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+    arena_chunk *p_chunk = p_arena->p_chunks;
+    while (p_chunk != NULL)
+    {
+        arena_chunk *p_next = p_chunk->p_next;
+        free(p_chunk);
+        p_chunk = p_next;
+    }
+    free(p_arena);
+}
+
+static void *
+media_item_arena_alloc(media_item_arena *p_arena, size_t i_size)
+{
+    i_size = ARENA_ALIGN(i_size);
+    arena_chunk *p_chunk = p_arena->p_chunks;
+    if (p_chunk == NULL || p_chunk->i_size - p_chunk->i_used < i_size)
+    {
+        size_t i_chunk_size = p_arena->i_next_chunk_size;
+        if (i_chunk_size < i_size)
+            i_chunk_size = i_size;
+        p_chunk = malloc(ARENA_ALIGN(sizeof(*p_chunk)) + i_chunk_size);
+        if (!p_chunk)
+            return NULL;
+        p_chunk->i_size = i_chunk_size;
+        p_chunk->i_used = 0;
+        p_chunk->p_next = p_arena->p_chunks;
+        p_arena->p_chunks = p_chunk;
+        if (p_arena->i_next_chunk_size < ARENA_MAX_CHUNK_SIZE)
+            p_arena->i_next_chunk_size *= 2;
+    }
+    void *p_res = (char *)p_chunk + ARENA_ALIGN(sizeof(*p_chunk)) + p_chunk->i_used;
+    p_chunk->i_used += i_size;
+    return p_res;
+}
+
+char *
+media_item_arena_strndup(media_item_arena *p_arena, const char *psz_str, size_t i_len)
+{
+    char *psz_res = media_item_arena_alloc(p_arena, i_len + 1);
+    if (!psz_res)
+        return NULL;
+    memcpy(psz_res, psz_str, i_len);
+    psz_res[i_len] = 0;
+    return psz_res;
+}
+
+char *
+media_item_arena_strdup(media_item_arena *p_arena, const char *psz_str)
+{
+    return media_item_arena_strndup(p_arena, psz_str, strlen(psz_str));
+}
+
+/* Metas which are interned instead of being copied */
+#define SHARED_METAS ((1 << MEDIA_ITEM_META_ARTIST) | \
+                      (1 << MEDIA_ITEM_META_ALBUM) | \
+                      (1 << MEDIA_ITEM_META_GENRE))
+
+static inline bool
+media_item_meta_is_shared(unsigned int i_meta)
+{
+    return (SHARED_METAS & (1 << i_meta)) != 0;
+}
+
+media_item *
+media_item_arena_create_item(media_item_arena *p_arena, const char *psz_path, enum MEDIA_ITEM_TYPE i_type)
+{
+    media_item *p_mi = media_item_arena_alloc(p_arena, sizeof(*p_mi));
+    if (!p_mi)
+        return NULL;
+    memset(p_mi, 0, sizeof(*p_mi));
+    p_mi->i_library_item_type = LIBRARY_ITEM_MEDIA;
+    p_mi->i_refs = 1;
+    p_mi->psz_path = eina_stringshare_add(psz_path);
+    if (!p_mi->psz_path)
+        return NULL;
+    p_mi->i_type = i_type;
+    p_mi->i_duration = -1;
+    p_mi->p_arena = p_arena;
+    media_item_arena_hold(p_arena);
+    return p_mi;
+}
+
 media_item *
 media_item_create(const char *psz_path, enum MEDIA_ITEM_TYPE i_type)
 {
@@ -33,7 +164,8 @@ media_item_create(const char *psz_path, enum MEDIA_ITEM_TYPE i_type)
         return NULL;
 
     p_mi->i_library_item_type = LIBRARY_ITEM_MEDIA;
-    p_mi->psz_path = strdup(psz_path);
+    p_mi->i_refs = 1;
+    p_mi->psz_path = eina_stringshare_add(psz_path);
     if (!p_mi->psz_path)
         goto error;
 
@@ -49,20 +181,31 @@ error:
 media_item*
 media_item_copy(const media_item* p_item)
 {
-    media_item* p_new = media_item_create(p_item->psz_path, p_item->i_type);
+    media_item* p_new = calloc(1, sizeof(*p_new));
     if (p_new == NULL)
         return NULL;
+    p_new->i_library_item_type = LIBRARY_ITEM_MEDIA;
+    p_new->i_refs = 1;
+    p_new->psz_path = eina_stringshare_ref(p_item->psz_path);
+    p_new->i_type = p_item->i_type;
+    p_new->i_id = p_item->i_id;
     p_new->i_duration = p_item->i_duration;
     p_new->i_w = p_item->i_w;
     p_new->i_h = p_item->i_h;
     p_new->i_track_number = p_item->i_track_number;
+    p_new->i_year = p_item->i_year;
+    p_new->i_album_id = p_item->i_album_id;
+    p_new->i_artist_id = p_item->i_artist_id;
     for (unsigned int i = 0; i < MEDIA_ITEM_META_COUNT; ++i)
     {
-        if (p_item->psz_metas[i] != NULL)
-            p_new->psz_metas[i] = strdup( p_item->psz_metas[i]);
+        if (p_item->psz_metas[i] == NULL)
+            continue;
+        if (media_item_meta_is_shared(i))
+            p_new->psz_metas[i] = eina_stringshare_ref(p_item->psz_metas[i]);
+        else
+            p_new->psz_metas[i] = strdup(p_item->psz_metas[i]);
     }
-    if (p_item->psz_snapshot != NULL)
-        p_new->psz_snapshot = strdup(p_item->psz_snapshot);
+    p_new->psz_snapshot = eina_stringshare_ref(p_item->psz_snapshot);
     return p_new;
 }
 
@@ -71,24 +214,90 @@ media_item_identical(const media_item* p_left, const media_item* p_right)
 {
     if ( p_left->i_id != 0 && p_right->i_id != 0 )
         return p_left->i_id == p_right->i_id && p_left->i_type == p_right->i_type;
-    return strcmp( p_left->psz_path, p_right->psz_path ) == 0;
+    return p_left->psz_path == p_right->psz_path;
+}
+
+media_item*
+media_item_writable(media_item* p_mi)
+{
+    if (!library_item_is_shared((library_item*)p_mi))
+        return p_mi;
+    media_item *p_copy = media_item_copy(p_mi);
+    if (!p_copy)
+        return NULL;
+    media_item_destroy(p_mi);
+    return p_copy;
+}
+
+media_item*
+media_item_detach(media_item* p_mi)
+{
+    if (p_mi->p_arena == NULL)
+        return p_mi;
+    media_item *p_copy = media_item_copy(p_mi);
+    if (!p_copy)
+        return p_mi;
+    media_item_destroy(p_mi);
+    return p_copy;
 }
 
 void
 media_item_destroy(media_item *p_mi)
 {
-    free(p_mi->psz_snapshot);
+    if (!library_item_unref((library_item*)p_mi))
+        return;
+    eina_stringshare_del(p_mi->psz_path);
+    eina_stringshare_del(p_mi->psz_snapshot);
     for (unsigned int i = 0; i < MEDIA_ITEM_META_COUNT; ++i)
-        free(p_mi->psz_metas[i]);
-    free(p_mi->psz_path);
-    free(p_mi);
+    {
+        if (media_item_meta_is_shared(i))
+            eina_stringshare_del(p_mi->psz_metas[i]);
+        else if (p_mi->p_arena == NULL || (p_mi->i_heap_metas & (1 << i)))
+            free((char *)p_mi->psz_metas[i]);
+    }
+    if (p_mi->p_arena != NULL)
+        media_item_arena_release(p_mi->p_arena);
+    else
+        free(p_mi);
+}
+
+void
+media_item_set_snapshot(media_item *p_mi, const char *psz_snapshot)
+{
+    eina_stringshare_replace(&p_mi->psz_snapshot, psz_snapshot);
 }
 
 int
 media_item_set_meta(media_item *p_mi, enum MEDIA_ITEM_META i_meta,
                     const char *psz_meta)
 {
-    free(p_mi->psz_metas[i_meta]);
+    if (i_meta == MEDIA_ITEM_META_YEAR)
+    {
+        p_mi->i_year = psz_meta ? atoi(psz_meta) : 0;
+        return 0;
+    }
+    if (media_item_meta_is_shared(i_meta))
+    {
+        eina_stringshare_replace(&p_mi->psz_metas[i_meta], psz_meta);
+        return p_mi->psz_metas[i_meta] ? 0 : -1;
+    }
+    /* The arena can't be used once the item has been handed over, the new
+     * meta is allocated on its own */
+    if (p_mi->p_arena == NULL || (p_mi->i_heap_metas & (1 << i_meta)))
+        free((char *)p_mi->psz_metas[i_meta]);
+    if (p_mi->p_arena != NULL)
+        p_mi->i_heap_metas |= 1 << i_meta;
     p_mi->psz_metas[i_meta] = psz_meta ? strdup(psz_meta) : NULL;
     return p_mi->psz_metas[i_meta] ? 0 : -1;
 }
+
+int
+media_item_arena_set_meta(media_item *p_mi, enum MEDIA_ITEM_META i_meta,
+                          const char *psz_meta)
+{
+    if (i_meta == MEDIA_ITEM_META_YEAR || media_item_meta_is_shared(i_meta) ||
+            p_mi->p_arena == NULL)
+        return media_item_set_meta(p_mi, i_meta, psz_meta);
+    p_mi->psz_metas[i_meta] = psz_meta ? media_item_arena_strdup(p_mi->p_arena, psz_meta) : NULL;
+    return p_mi->psz_metas[i_meta] ? 0 : -1;
+}
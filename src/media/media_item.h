@@ -52,29 +52,88 @@ enum MEDIA_ITEM_META {
     MEDIA_ITEM_META_COUNT,
 };
 
+/*
+ * Arena holding the items of a whole result set, along with their strings.
+ * Items created from an arena hold a reference on it, and it is freed at once
+ * when the last of them is destroyed.
+ * Only one thread at a time may create items from an arena.
+ */
+typedef struct media_item_arena media_item_arena;
+
+/*
+ * Paths, as well as artist, album and genre names, are repeated across many
+ * items. They are interned as Eina_Stringshare, and can be compared by
+ * pointer.
+ */
 typedef struct media_item {
     LIBRARY_ITEM_COMMON
 
-    char *psz_path;                 /* Normalized path on the device */
+    const char *psz_path;           /* Normalized path on the device, interned */
     enum MEDIA_ITEM_TYPE i_type;    /* Video, Audio, Subs, etc... */
 
-    char *psz_metas[MEDIA_ITEM_META_COUNT];
+    const char *psz_metas[MEDIA_ITEM_META_COUNT]; /* Except MEDIA_ITEM_META_YEAR, see i_year */
     int64_t i_duration;             /* in ms */
 
     //FIXME replace with a union
     int i_w, i_h;                   /* in pixels */
 
-    char* psz_snapshot;             /* Path to a snapshot file */
+    const char* psz_snapshot;       /* Path to a snapshot file, interned */
     uint32_t i_id;                  /* Opaque file type specific ID, provided by the media library */
     uint16_t i_track_number;        /* Track number, or 0 if unknown or not part of an album */
+    uint16_t i_year;                /* Release year, or 0 if unknown */
+    uint32_t i_album_id;            /* Media library ID of the album of the track, or 0 */
+    uint32_t i_artist_id;           /* Media library ID of the artist of the track, or 0 */
+
+    media_item_arena* p_arena;      /* Arena the item was created from, if any */
+    uint8_t i_heap_metas;           /* Metas of an arena item that were set afterward, and live on the heap */
 } media_item;
 
+media_item_arena *
+media_item_arena_create(void);
+
+/* Releases the reference of the arena creator */
+void
+media_item_arena_release(media_item_arena *p_arena);
+
+/* Creates an item which, as well as all its strings, lives in the arena */
+media_item *
+media_item_arena_create_item(media_item_arena *p_arena, const char *psz_path, enum MEDIA_ITEM_TYPE i_type);
+
+/* Copies a string into the arena. The result is freed along with the arena */
+char *
+media_item_arena_strdup(media_item_arena *p_arena, const char *psz_str);
+
+char *
+media_item_arena_strndup(media_item_arena *p_arena, const char *psz_str, size_t i_len);
+
 media_item *
 media_item_create(const char *psz_path, enum MEDIA_ITEM_TYPE i_type);
 
+/* Sets the snapshot path, which gets interned */
+void
+media_item_set_snapshot(media_item *p_mi, const char *psz_snapshot);
+
+/* Deep copy. Use library_item_hold to share an item */
 media_item*
 media_item_copy(const media_item* p_item);
 
+/*
+ * Returns an item which can be modified: the item itself if the caller holds
+ * the only reference, or a copy of it. In the latter case, the caller's
+ * reference on p_mi is released.
+ */
+media_item*
+media_item_writable(media_item* p_mi);
+
+/*
+ * Returns an item which doesn't keep an arena alive, for items that outlive
+ * most of their result set: the item itself if it wasn't created from an
+ * arena, or a copy of it. In the latter case, the caller's reference on p_mi
+ * is released. If the copy fails, p_mi is returned as is.
+ */
+media_item*
+media_item_detach(media_item* p_mi);
+
 void
 media_item_destroy(media_item *p_mi);
 
@@ -84,6 +143,10 @@ media_item_identical(const media_item* p_left, const media_item* p_right);
 int
 media_item_set_meta(media_item *p_mi, enum MEDIA_ITEM_META i_meta, const char *psz_meta);
 
+/* Same as media_item_set_meta, for items being filled by their arena creator */
+int
+media_item_arena_set_meta(media_item *p_mi, enum MEDIA_ITEM_META i_meta, const char *psz_meta);
+
 static inline const char *
 media_item_get_filename(const media_item *p_mi)
 {
@@ -93,7 +156,7 @@ media_item_get_filename(const media_item *p_mi)
 #define media_item_title(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_TITLE]
 #define media_item_artist(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_ARTIST]
 #define media_item_album(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_ALBUM]
-#define media_item_year(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_YEAR]
+#define media_item_year(p_mi) (p_mi)->i_year
 #define media_item_genre(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_GENRE]
 #define media_item_comment(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_COMMENT]
 #define media_item_disc_id(p_mi) (p_mi)->psz_metas[MEDIA_ITEM_META_DISC_ID]
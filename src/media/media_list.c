@@ -25,20 +25,59 @@
 #include "common.h"
 
 #include <assert.h>
-#include <eina_array.h>
-#include <eina_list.h>
+#include <time.h>
+#include <unistd.h>
+#include <Eina.h>
 
 #include "media_list.h"
 
+/*
+ * The items are kept in an implicit treap: a randomized binary search tree
+ * ordered by position, where each node knows the size of its subtree. Reaching
+ * a position, inserting or removing an item are then O(log n).
+ * Nodes are also indexed by item, and know their parent, so that the position
+ * of an item is found in O(log n) as well.
+ *
+ * In shuffle mode, the play order is drawn lazily, without touching the tree:
+ * the nodes already played are chained in the order they were played, and the
+ * others wait in an unordered pool. Moving past either end of the chain draws
+ * a random node out of the pool, which is O(1).
+ */
+typedef struct media_list_node media_list_node;
+struct media_list_node
+{
+    media_list_node *p_left;
+    media_list_node *p_right;
+    media_list_node *p_parent;
+    /* Next node holding the same item, an item can be queued more than once */
+    media_list_node *p_next_same;
+    media_item *p_mi;
+    uint32_t i_priority;
+    unsigned int i_count;   /* Nodes in this subtree */
+
+    /* Shuffle mode only */
+    media_list_node *p_shuffle_prev;
+    media_list_node *p_shuffle_next;
+    int i_unplayed;         /* Slot in the unplayed pool, -1 once played */
+};
+
 struct media_list
 {
     Eina_List *p_cbs_list;
-    Eina_Array *p_item_array;
+    media_list_node *p_root;
+    Eina_Hash *p_nodes;     /* media_item* -> first media_list_node* holding it */
+    uint32_t i_seed;
+    media_list_node *p_node;    /* Current node */
     media_item *p_mi;
     int i_pos;
     bool b_free_media;
 
     enum PLAYLIST_REPEAT i_repeat;
+
+    bool b_shuffle;
+    media_list_node **pp_unplayed;
+    unsigned int i_unplayed;
+    unsigned int i_unplayed_max;
 };
 
 #define ML_SEND_CALLBACK(pf_cb, ...) do { \
@@ -49,44 +88,465 @@ struct media_list
             p_cbs->pf_cb(p_ml, p_cbs->p_user_data, __VA_ARGS__); \
 } while (0)
 
+/* Subscribers without a range callback get one per item callback per item */
+#define ML_SEND_RANGE_CALLBACK(pf_range_cb, pf_cb, i_index, pp_items, i_count) do { \
+    Eina_List *p_el; \
+    media_list_callbacks *p_cbs; \
+    EINA_LIST_FOREACH(p_ml->p_cbs_list, p_el, p_cbs) { \
+        if (p_cbs->pf_range_cb) \
+            p_cbs->pf_range_cb(p_ml, p_cbs->p_user_data, i_index, pp_items, i_count); \
+        else if (p_cbs->pf_cb) \
+            for (unsigned int i_item = 0; i_item < (i_count); ++i_item) \
+                p_cbs->pf_cb(p_ml, p_cbs->p_user_data, (i_index) + i_item, (pp_items)[i_item]); \
+    } \
+} while (0)
+
+/* Negative positions are clipped too */
 #define ML_CLIP_POS(i_pos) do { \
-    if (i_pos >= eina_array_count(p_ml->p_item_array)) \
-        i_pos = eina_array_count(p_ml->p_item_array) - 1; \
+    if ((unsigned int)(i_pos) >= node_count(p_ml->p_root)) \
+        i_pos = node_count(p_ml->p_root) - 1; \
 } while (0)
 
+static inline unsigned int
+node_count(const media_list_node *p_node)
+{
+    return p_node != NULL ? p_node->i_count : 0;
+}
+
 static void
-media_list_on_new_pos(media_list *p_ml)
+node_update(media_list_node *p_node)
 {
-    ML_SEND_CALLBACK(pf_on_media_selected, p_ml->i_pos, p_ml->p_mi);
+    p_node->i_count = 1 + node_count(p_node->p_left) + node_count(p_node->p_right);
+    if (p_node->p_left != NULL)
+        p_node->p_left->p_parent = p_node;
+    if (p_node->p_right != NULL)
+        p_node->p_right->p_parent = p_node;
+}
+
+/* Splits the tree in its first i_index nodes, and the others */
+static void
+tree_split(media_list_node *p_node, unsigned int i_index,
+           media_list_node **pp_left, media_list_node **pp_right)
+{
+    if (p_node == NULL)
+    {
+        *pp_left = *pp_right = NULL;
+        return;
+    }
+    unsigned int i_left = node_count(p_node->p_left);
+    if (i_left < i_index)
+    {
+        tree_split(p_node->p_right, i_index - i_left - 1, &p_node->p_right, pp_right);
+        *pp_left = p_node;
+    }
+    else
+    {
+        tree_split(p_node->p_left, i_index, pp_left, &p_node->p_left);
+        *pp_right = p_node;
+    }
+    node_update(p_node);
+    p_node->p_parent = NULL;
+}
+
+/* Concatenates two trees */
+static media_list_node *
+tree_merge(media_list_node *p_left, media_list_node *p_right)
+{
+    if (p_left == NULL)
+        return p_right;
+    if (p_right == NULL)
+        return p_left;
+    if (p_left->i_priority > p_right->i_priority)
+    {
+        p_left->p_right = tree_merge(p_left->p_right, p_right);
+        node_update(p_left);
+        return p_left;
+    }
+    p_right->p_left = tree_merge(p_left, p_right->p_left);
+    node_update(p_right);
+    return p_right;
+}
+
+static unsigned int
+tree_fix_counts(media_list_node *p_node)
+{
+    if (p_node == NULL)
+        return 0;
+    p_node->i_count = 1 + tree_fix_counts(p_node->p_left) + tree_fix_counts(p_node->p_right);
+    return p_node->i_count;
+}
+
+/* Builds a tree out of nodes given in order, in O(n) */
+static media_list_node *
+tree_build(media_list_node **pp_nodes, unsigned int i_count)
+{
+    media_list_node *p_last = NULL;
+
+    /* Cartesian tree: each node becomes the right child of the last node with
+     * a higher priority, and adopts the lower ones as its left child */
+    for (unsigned int i = 0; i < i_count; ++i)
+    {
+        media_list_node *p_node = pp_nodes[i];
+        media_list_node *p_child = NULL;
+        while (p_last != NULL && p_last->i_priority < p_node->i_priority)
+        {
+            p_child = p_last;
+            p_last = p_last->p_parent;
+        }
+        p_node->p_left = p_child;
+        if (p_child != NULL)
+            p_child->p_parent = p_node;
+        p_node->p_parent = p_last;
+        if (p_last != NULL)
+            p_last->p_right = p_node;
+        p_last = p_node;
+    }
+    if (p_last == NULL)
+        return NULL;
+    while (p_last->p_parent != NULL)
+        p_last = p_last->p_parent;
+    tree_fix_counts(p_last);
+    return p_last;
+}
+
+static media_list_node *
+tree_at(media_list_node *p_node, unsigned int i_index)
+{
+    while (p_node != NULL)
+    {
+        unsigned int i_left = node_count(p_node->p_left);
+        if (i_index == i_left)
+            return p_node;
+        if (i_index < i_left)
+            p_node = p_node->p_left;
+        else
+        {
+            i_index -= i_left + 1;
+            p_node = p_node->p_right;
+        }
+    }
+    return NULL;
+}
+
+static unsigned int
+node_index(const media_list_node *p_node)
+{
+    unsigned int i_index = node_count(p_node->p_left);
+    for (; p_node->p_parent != NULL; p_node = p_node->p_parent)
+    {
+        if (p_node == p_node->p_parent->p_right)
+            i_index += node_count(p_node->p_parent->p_left) + 1;
+    }
+    return i_index;
+}
+
+static media_list_node *
+tree_first(media_list_node *p_node)
+{
+    if (p_node == NULL)
+        return NULL;
+    while (p_node->p_left != NULL)
+        p_node = p_node->p_left;
+    return p_node;
+}
+
+static media_list_node *
+node_next(media_list_node *p_node)
+{
+    if (p_node->p_right != NULL)
+        return tree_first(p_node->p_right);
+    while (p_node->p_parent != NULL && p_node == p_node->p_parent->p_right)
+        p_node = p_node->p_parent;
+    return p_node->p_parent;
+}
+
+static void
+tree_free(media_list_node *p_node)
+{
+    if (p_node == NULL)
+        return;
+    tree_free(p_node->p_left);
+    tree_free(p_node->p_right);
+    free(p_node);
 }
 
 static void
-media_list_on_media_added(media_list *p_ml, unsigned int i_index, media_item *p_mi)
+media_list_index_add(media_list *p_ml, media_list_node *p_node)
 {
-    if (p_ml->i_pos >= 0 && p_ml->i_pos >= i_index)
+    p_node->p_next_same = eina_hash_find(p_ml->p_nodes, &p_node->p_mi);
+    if (p_node->p_next_same != NULL)
+        eina_hash_modify(p_ml->p_nodes, &p_node->p_mi, p_node);
+    else
+        eina_hash_add(p_ml->p_nodes, &p_node->p_mi, p_node);
+}
+
+static void
+media_list_index_del(media_list *p_ml, media_list_node *p_node)
+{
+    media_list_node *p_first = eina_hash_find(p_ml->p_nodes, &p_node->p_mi);
+    if (p_first == p_node)
     {
-        // A media has been inserted before the current media
-        // we need to shift its position.
-        p_ml->i_pos++;
+        if (p_node->p_next_same != NULL)
+            eina_hash_modify(p_ml->p_nodes, &p_node->p_mi, p_node->p_next_same);
+        else
+            eina_hash_del_by_key(p_ml->p_nodes, &p_node->p_mi);
     }
+    else
+    {
+        while (p_first != NULL && p_first->p_next_same != p_node)
+            p_first = p_first->p_next_same;
+        if (p_first != NULL)
+            p_first->p_next_same = p_node->p_next_same;
+    }
+    p_node->p_next_same = NULL;
+}
 
-    ML_SEND_CALLBACK(pf_on_media_added, i_index, p_mi);
+/* Returns the node holding p_mi at the lowest position */
+static media_list_node *
+media_list_find_node(media_list *p_ml, media_item *p_mi)
+{
+    media_list_node *p_best = eina_hash_find(p_ml->p_nodes, &p_mi);
+    if (p_best == NULL || p_best->p_next_same == NULL)
+        return p_best;
+    unsigned int i_best = node_index(p_best);
+    for (media_list_node *p_node = p_best->p_next_same; p_node != NULL; p_node = p_node->p_next_same)
+    {
+        unsigned int i_index = node_index(p_node);
+        if (i_index < i_best)
+        {
+            p_best = p_node;
+            i_best = i_index;
+        }
+    }
+    return p_best;
 }
 
 static void
-media_list_on_media_removed(media_list *p_ml, unsigned int i_index, media_item *p_mi)
+media_list_tree_insert(media_list *p_ml, unsigned int i_index, media_list_node *p_node)
 {
-    if (p_ml->i_pos >= 0 && p_ml->i_pos >= i_index)
+    media_list_node *p_left, *p_right;
+
+    tree_split(p_ml->p_root, i_index, &p_left, &p_right);
+    p_ml->p_root = tree_merge(tree_merge(p_left, p_node), p_right);
+    p_ml->p_root->p_parent = NULL;
+}
+
+static media_list_node *
+media_list_tree_remove(media_list *p_ml, unsigned int i_index)
+{
+    media_list_node *p_left, *p_node, *p_right;
+
+    tree_split(p_ml->p_root, i_index, &p_left, &p_right);
+    tree_split(p_right, 1, &p_node, &p_right);
+    p_ml->p_root = tree_merge(p_left, p_right);
+    if (p_ml->p_root != NULL)
+        p_ml->p_root->p_parent = NULL;
+    return p_node;
+}
+
+static media_item *
+media_list_item_at(media_list *p_ml, unsigned int i_index)
+{
+    media_list_node *p_node = tree_at(p_ml->p_root, i_index);
+    return p_node != NULL ? p_node->p_mi : NULL;
+}
+
+static uint32_t
+media_list_random(media_list *p_ml)
+{
+    /* xorshift32, the priorities only need to be spread out */
+    uint32_t x = p_ml->i_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    p_ml->i_seed = x;
+    return x;
+}
+
+/* Builds with MEDIA_LIST_SEED defined get the same shuffle order every time,
+ * to reproduce a sequence */
+static uint32_t
+media_list_initial_seed(const media_list *p_ml)
+{
+#ifdef MEDIA_LIST_SEED
+    (void)p_ml;
+    return MEDIA_LIST_SEED;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint32_t i_seed = (uint32_t)ts.tv_nsec ^ (uint32_t)ts.tv_sec * 2654435761u
+                    ^ (uint32_t)getpid() << 16 ^ (uint32_t)(uintptr_t)p_ml;
+    /* 0 is the only value xorshift can't leave */
+    return i_seed != 0 ? i_seed : 2463534242u;
+#endif
+}
+
+static bool
+media_list_unplayed_add(media_list *p_ml, media_list_node *p_node)
+{
+    if (p_ml->i_unplayed == p_ml->i_unplayed_max)
     {
-        // A media has been removed before the current media
-        // we need to shift its position.
-        p_ml->i_pos--;
+        unsigned int i_max = p_ml->i_unplayed_max ? p_ml->i_unplayed_max * 2 : 16;
+        media_list_node **pp_unplayed = realloc(p_ml->pp_unplayed, i_max * sizeof(*pp_unplayed));
+        if (pp_unplayed == NULL)
+        {
+            /* It won't be played before the next shuffle cycle */
+            p_node->i_unplayed = -1;
+            return false;
+        }
+        p_ml->pp_unplayed = pp_unplayed;
+        p_ml->i_unplayed_max = i_max;
     }
+    p_node->i_unplayed = p_ml->i_unplayed;
+    p_ml->pp_unplayed[p_ml->i_unplayed++] = p_node;
+    return true;
+}
 
-    ML_SEND_CALLBACK(pf_on_media_removed, i_index, p_mi);
+static void
+media_list_unplayed_del(media_list *p_ml, media_list_node *p_node)
+{
+    /* The last node of the pool takes the slot of the removed one */
+    media_list_node *p_last = p_ml->pp_unplayed[--p_ml->i_unplayed];
+    p_ml->pp_unplayed[p_node->i_unplayed] = p_last;
+    p_last->i_unplayed = p_node->i_unplayed;
+    p_node->i_unplayed = -1;
+}
 
-    if (p_ml->b_free_media)
-        media_item_destroy(p_mi);
+static media_list_node *
+media_list_unplayed_pick(media_list *p_ml)
+{
+    if (p_ml->i_unplayed == 0)
+        return NULL;
+    media_list_node *p_node = p_ml->pp_unplayed[media_list_random(p_ml) % p_ml->i_unplayed];
+    media_list_unplayed_del(p_ml, p_node);
+    return p_node;
+}
+
+static void
+shuffle_link_after(media_list_node *p_prev, media_list_node *p_node)
+{
+    p_node->p_shuffle_prev = p_prev;
+    p_node->p_shuffle_next = p_prev != NULL ? p_prev->p_shuffle_next : NULL;
+    if (p_node->p_shuffle_next != NULL)
+        p_node->p_shuffle_next->p_shuffle_prev = p_node;
+    if (p_prev != NULL)
+        p_prev->p_shuffle_next = p_node;
+}
+
+static void
+shuffle_link_before(media_list_node *p_next, media_list_node *p_node)
+{
+    p_node->p_shuffle_next = p_next;
+    p_node->p_shuffle_prev = p_next != NULL ? p_next->p_shuffle_prev : NULL;
+    if (p_node->p_shuffle_prev != NULL)
+        p_node->p_shuffle_prev->p_shuffle_next = p_node;
+    if (p_next != NULL)
+        p_next->p_shuffle_prev = p_node;
+}
+
+/* Forgets about a node leaving the list */
+static void
+media_list_shuffle_del(media_list *p_ml, media_list_node *p_node)
+{
+    if (p_node->i_unplayed >= 0)
+    {
+        media_list_unplayed_del(p_ml, p_node);
+        return;
+    }
+    if (p_node->p_shuffle_prev != NULL)
+        p_node->p_shuffle_prev->p_shuffle_next = p_node->p_shuffle_next;
+    if (p_node->p_shuffle_next != NULL)
+        p_node->p_shuffle_next->p_shuffle_prev = p_node->p_shuffle_prev;
+    p_node->p_shuffle_prev = p_node->p_shuffle_next = NULL;
+}
+
+/* Starts a new shuffle cycle, only the current node counts as played */
+static bool
+media_list_shuffle_reset(media_list *p_ml)
+{
+    unsigned int i_count = node_count(p_ml->p_root);
+    if (i_count > p_ml->i_unplayed_max)
+    {
+        media_list_node **pp_unplayed = realloc(p_ml->pp_unplayed, i_count * sizeof(*pp_unplayed));
+        if (pp_unplayed == NULL)
+            return false;
+        p_ml->pp_unplayed = pp_unplayed;
+        p_ml->i_unplayed_max = i_count;
+    }
+    p_ml->i_unplayed = 0;
+    for (media_list_node *p_node = tree_first(p_ml->p_root); p_node != NULL; p_node = node_next(p_node))
+    {
+        p_node->p_shuffle_prev = p_node->p_shuffle_next = NULL;
+        if (p_node == p_ml->p_node)
+            p_node->i_unplayed = -1;
+        else
+        {
+            p_node->i_unplayed = p_ml->i_unplayed;
+            p_ml->pp_unplayed[p_ml->i_unplayed++] = p_node;
+        }
+    }
+    return true;
+}
+
+static void
+media_list_on_new_pos(media_list *p_ml)
+{
+    ML_SEND_CALLBACK(pf_on_media_selected, p_ml->i_pos, p_ml->p_mi);
+}
+
+/* Makes p_node the current node, and notifies it */
+static void
+media_list_select(media_list *p_ml, media_list_node *p_node)
+{
+    /* An item picked by hand is played right after the current one */
+    if (p_ml->b_shuffle && p_node != NULL && p_node->i_unplayed >= 0)
+    {
+        media_list_unplayed_del(p_ml, p_node);
+        shuffle_link_after(p_ml->p_node, p_node);
+    }
+    p_ml->p_node = p_node;
+    p_ml->p_mi = p_node != NULL ? p_node->p_mi : NULL;
+    p_ml->i_pos = p_node != NULL ? (int)node_index(p_node) : -1;
+    media_list_on_new_pos(p_ml);
+}
+
+/* Returns the next or previous node of the shuffled order, drawing it out of
+ * the unplayed ones when needed */
+static media_list_node *
+media_list_shuffle_peek(media_list *p_ml, bool b_forward)
+{
+    media_list_node *p_cur = p_ml->p_node;
+    media_list_node *p_node = NULL;
+
+    if (p_cur != NULL)
+        p_node = b_forward ? p_cur->p_shuffle_next : p_cur->p_shuffle_prev;
+    if (p_node != NULL)
+        return p_node;
+
+    if (p_ml->i_unplayed == 0)
+    {
+        /* Every item was played */
+        if (p_ml->i_repeat != REPEAT_ALL || p_cur == NULL || !media_list_shuffle_reset(p_ml))
+            return NULL;
+        if (p_ml->i_unplayed == 0)
+            return p_cur;
+    }
+    p_node = media_list_unplayed_pick(p_ml);
+    if (b_forward)
+        shuffle_link_after(p_cur, p_node);
+    else
+        shuffle_link_before(p_cur, p_node);
+    return p_node;
+}
+
+static bool
+media_list_shuffle_step(media_list *p_ml, bool b_forward)
+{
+    media_list_node *p_node = media_list_shuffle_peek(p_ml, b_forward);
+    if (p_node == NULL)
+        return false;
+    media_list_select(p_ml, p_node);
+    return true;
 }
 
 media_list *
@@ -95,13 +555,14 @@ media_list_create(bool b_free_media)
     media_list *p_ml = calloc(1, sizeof(media_list));
     if (!p_ml)
         return NULL;
-    p_ml->p_item_array = eina_array_new(30);
-    if (!p_ml->p_item_array)
+    p_ml->p_nodes = eina_hash_pointer_new(NULL);
+    if (!p_ml->p_nodes)
     {
         free(p_ml);
         return NULL;
     }
 
+    p_ml->i_seed = media_list_initial_seed(p_ml);
     p_ml->b_free_media = b_free_media;
     p_ml->i_pos = -1;
     p_ml->i_repeat = REPEAT_NONE;
@@ -121,7 +582,8 @@ media_list_destroy(media_list *p_ml)
     p_ml->p_cbs_list = NULL;
 
     media_list_clear(p_ml);
-    eina_array_free(p_ml->p_item_array);
+    eina_hash_free(p_ml->p_nodes);
+    free(p_ml->pp_unplayed);
     free(p_ml);
 }
 
@@ -150,126 +612,224 @@ media_list_unregister_callbacks(media_list *p_ml, media_list_cbs_id *p_id)
     free(p_id);
 }
 
-int
-media_list_insert(media_list *p_ml, int i_index, media_item *p_mi)
+static int
+media_list_insert_range_common(media_list *p_ml, int i_index, media_item **pp_items, unsigned int i_count,
+                               bool b_select)
 {
-    if (i_index < 0)
+    if (i_count == 0)
+        return 0;
+    media_list_node **pp_nodes = malloc(i_count * sizeof(*pp_nodes));
+    if (pp_nodes == NULL)
+        return -1;
+    for (unsigned int i = 0; i < i_count; ++i)
     {
-        if (!eina_array_push(p_ml->p_item_array, p_mi))
+        pp_nodes[i] = calloc(1, sizeof(**pp_nodes));
+        if (pp_nodes[i] == NULL)
+        {
+            while (i > 0)
+                free(pp_nodes[--i]);
+            free(pp_nodes);
             return -1;
+        }
+        pp_nodes[i]->p_mi = pp_items[i];
+        pp_nodes[i]->i_priority = media_list_random(p_ml);
     }
-    else
-    {
-        unsigned int i_count;
-        /* increase array size */
-        if (!eina_array_push(p_ml->p_item_array, p_mi)) // dummy data
-            return -1;
 
-        /* "memmove" */
-        i_count = eina_array_count(p_ml->p_item_array);
-        for (unsigned int i = i_count - 1; i > i_index; --i)
-        {
-            media_item *p_move_mi = eina_array_data_get(p_ml->p_item_array, i - 1);
-            eina_array_data_set(p_ml->p_item_array, i, p_move_mi);
-        }
-        eina_array_data_set(p_ml->p_item_array, i_index, p_mi);
+    unsigned int i_total = node_count(p_ml->p_root);
+    unsigned int i_pos = i_index < 0 || (unsigned int)i_index > i_total ? i_total : (unsigned int)i_index;
+    media_list_node *p_left, *p_right;
+    tree_split(p_ml->p_root, i_pos, &p_left, &p_right);
+    p_ml->p_root = tree_merge(tree_merge(p_left, tree_build(pp_nodes, i_count)), p_right);
+    p_ml->p_root->p_parent = NULL;
+    for (unsigned int i = 0; i < i_count; ++i)
+    {
+        media_list_index_add(p_ml, pp_nodes[i]);
+        if (p_ml->b_shuffle)
+            media_list_unplayed_add(p_ml, pp_nodes[i]);
     }
+    free(pp_nodes);
+
+    if (p_ml->i_pos >= 0 && (unsigned int)p_ml->i_pos >= i_pos)
+        p_ml->i_pos += i_count;
 
-    media_list_on_media_added(p_ml, i_index, p_mi);
+    ML_SEND_RANGE_CALLBACK(pf_on_media_range_added, pf_on_media_added, i_pos, pp_items, i_count);
 
-    if (p_ml->i_pos == -1)
+    if (b_select && p_ml->i_pos == -1)
         media_list_set_pos(p_ml, 0);
 
     return 0;
 }
 
-static Eina_Bool
-media_list_array_keep_cb(void *p_data, void *p_user_data)
+int
+media_list_insert_range(media_list *p_ml, int i_index, media_item **pp_items, unsigned int i_count)
 {
-   return (p_data == p_user_data) ? EINA_FALSE : EINA_TRUE;
+    return media_list_insert_range_common(p_ml, i_index, pp_items, i_count, true);
 }
 
-static int
-media_list_remove_common(media_list *p_ml, unsigned int i_index, media_item *p_mi)
+int
+media_list_insert(media_list *p_ml, int i_index, media_item *p_mi)
 {
-    int i_prev_count = eina_array_count(p_ml->p_item_array);
+    return media_list_insert_range(p_ml, i_index, &p_mi, 1);
+}
 
-    if (!eina_array_remove(p_ml->p_item_array, media_list_array_keep_cb, p_mi))
+int
+media_list_remove_range(media_list *p_ml, unsigned int i_index, unsigned int i_count)
+{
+    unsigned int i_total = node_count(p_ml->p_root);
+    if (i_index >= i_total)
+        return -1;
+    if (i_count > i_total - i_index)
+        i_count = i_total - i_index;
+    if (i_count == 0)
+        return 0;
+    media_item **pp_items = malloc(i_count * sizeof(*pp_items));
+    if (pp_items == NULL)
         return -1;
 
-    assert(eina_array_count(p_ml->p_item_array) != i_prev_count);
+    media_list_node *p_left, *p_removed, *p_right;
+    tree_split(p_ml->p_root, i_index, &p_left, &p_right);
+    tree_split(p_right, i_count, &p_removed, &p_right);
+    p_ml->p_root = tree_merge(p_left, p_right);
+    if (p_ml->p_root != NULL)
+        p_ml->p_root->p_parent = NULL;
+    else
+    {
+        eina_hash_free_buckets(p_ml->p_nodes);
+        p_ml->i_unplayed = 0;
+    }
 
-    media_list_on_media_removed(p_ml, i_index, p_mi);
+    bool b_current_removed = p_ml->i_pos >= 0 && (unsigned int)p_ml->i_pos >= i_index &&
+                             (unsigned int)p_ml->i_pos < i_index + i_count;
+    unsigned int i = 0;
+    for (media_list_node *p_node = tree_first(p_removed); p_node != NULL; p_node = node_next(p_node))
+    {
+        pp_items[i++] = p_node->p_mi;
+        if (p_ml->p_root == NULL)
+            continue;
+        media_list_index_del(p_ml, p_node);
+        if (p_ml->b_shuffle && p_node != p_ml->p_node)
+            media_list_shuffle_del(p_ml, p_node);
+    }
 
-    if (eina_array_count(p_ml->p_item_array) == 0)
+    media_list_node *p_shuffle_next = NULL;
+    if (b_current_removed && p_ml->b_shuffle && p_ml->p_root != NULL)
     {
-        /* notify there if no more current media */
-        p_ml->i_pos = -1;
-        p_ml->p_mi = NULL;
-        media_list_on_new_pos(p_ml);
+        /* Carry on in the shuffled order */
+        media_list_node *p_cur = p_ml->p_node;
+        p_shuffle_next = p_cur->p_shuffle_next;
+        if (p_shuffle_next == NULL)
+        {
+            p_shuffle_next = media_list_unplayed_pick(p_ml);
+            if (p_shuffle_next != NULL)
+                shuffle_link_after(p_cur, p_shuffle_next);
+            else
+                p_shuffle_next = p_cur->p_shuffle_prev;
+        }
+        media_list_shuffle_del(p_ml, p_cur);
+    }
+    if (b_current_removed)
+        p_ml->p_node = NULL;
+    tree_free(p_removed);
+    if (p_ml->i_pos >= 0 && (unsigned int)p_ml->i_pos >= i_index + i_count)
+        p_ml->i_pos -= i_count;
+
+    ML_SEND_RANGE_CALLBACK(pf_on_media_range_removed, pf_on_media_removed, i_index, pp_items, i_count);
+
+    if (p_ml->b_free_media)
+    {
+        for (i = 0; i < i_count; ++i)
+            media_item_destroy(pp_items[i]);
     }
-    else if (p_ml->i_pos == i_index)
+    free(pp_items);
+
+    if (p_ml->p_root == NULL)
     {
-        /* notify current media changed */
-        p_ml->p_mi = eina_array_data_get(p_ml->p_item_array, p_ml->i_pos);
-        media_list_on_new_pos(p_ml);
+        /* notify there if no more current media */
+        if (p_ml->i_pos != -1)
+            media_list_select(p_ml, NULL);
     }
-    else if (i_index < p_ml->i_pos)
+    else if (b_current_removed)
     {
-        p_ml->i_pos--;
+        /* the media following the removed ones becomes the current one */
+        i_total = node_count(p_ml->p_root);
+        if (p_shuffle_next == NULL)
+            p_shuffle_next = tree_at(p_ml->p_root, i_index < i_total ? i_index : i_total - 1);
+        media_list_select(p_ml, p_shuffle_next);
     }
+    return 0;
+}
 
+int
+media_list_replace_all(media_list *p_ml, media_item **pp_items, unsigned int i_count, int i_pos)
+{
+    media_list_clear(p_ml);
+    if (media_list_insert_range_common(p_ml, 0, pp_items, i_count, false) != 0)
+        return -1;
+    if (i_count > 0)
+        media_list_set_pos(p_ml, i_pos >= 0 ? i_pos : 0);
     return 0;
 }
 
 int
 media_list_remove(media_list *p_ml, media_item *p_mi)
 {
-    media_item *p_iter_mi;
-    Eina_Array_Iterator iterator;
-    unsigned int i;
-
-    EINA_ARRAY_ITER_NEXT(p_ml->p_item_array, i, p_iter_mi, iterator)
-    {
-        if (p_iter_mi == p_mi)
-            return media_list_remove_common(p_ml, i, p_mi);
-    }
-    return -1;
+    media_list_node *p_node = media_list_find_node(p_ml, p_mi);
+    if (p_node == NULL)
+        return -1;
+    return media_list_remove_range(p_ml, node_index(p_node), 1);
 }
 
 int
 media_list_remove_index(media_list *p_ml, unsigned int i_index)
 {
     ML_CLIP_POS(i_index);
-    media_item *p_mi = eina_array_data_get(p_ml->p_item_array, i_index);
-    if (!p_mi)
-        return -1;
-    return media_list_remove_common(p_ml, i_index, p_mi);
+    return media_list_remove_range(p_ml, i_index, 1);
 }
 
-void
-media_list_clear(media_list *p_ml)
+int
+media_list_move(media_list *p_ml, unsigned int i_from, unsigned int i_to)
 {
-    media_item *p_mi;
-    Eina_Array_Iterator iterator;
-    unsigned int i;
-
-    EINA_ARRAY_ITER_NEXT(p_ml->p_item_array, i, p_mi, iterator)
-        media_list_on_media_removed(p_ml, i, p_mi);
-    eina_array_flush(p_ml->p_item_array);
+    unsigned int i_count = node_count(p_ml->p_root);
+    if (i_from >= i_count || i_to >= i_count)
+        return -1;
+    if (i_from == i_to)
+        return 0;
+    media_list_node *p_node = media_list_tree_remove(p_ml, i_from);
+    media_list_tree_insert(p_ml, i_to, p_node);
 
-    if (p_ml->i_pos != -1)
+    /* The current media doesn't change, only its position might */
+    if (p_ml->i_pos >= 0)
     {
-        p_ml->i_pos = -1;
-        p_ml->p_mi = NULL;
-        media_list_on_new_pos(p_ml);
+        unsigned int i_pos = (unsigned int)p_ml->i_pos;
+        if (i_pos == i_from)
+            p_ml->i_pos = (int)i_to;
+        else if (i_from < i_pos && i_to >= i_pos)
+            p_ml->i_pos--;
+        else if (i_from > i_pos && i_to <= i_pos)
+            p_ml->i_pos++;
     }
+
+    ML_SEND_CALLBACK(pf_on_media_moved, i_from, i_to, p_node->p_mi);
+    return 0;
+}
+
+int
+media_list_index_of(media_list *p_ml, media_item *p_mi)
+{
+    media_list_node *p_node = media_list_find_node(p_ml, p_mi);
+    return p_node != NULL ? (int)node_index(p_node) : -1;
+}
+
+void
+media_list_clear(media_list *p_ml)
+{
+    media_list_remove_range(p_ml, 0, node_count(p_ml->p_root));
 }
 
 unsigned int
 media_list_get_count(media_list *p_ml)
 {
-    return eina_array_count(p_ml->p_item_array);
+    return node_count(p_ml->p_root);
 }
 
 int
@@ -284,16 +844,12 @@ media_list_set_pos(media_list *p_ml, int i_index)
     ML_CLIP_POS(i_index);
     if (i_index != p_ml->i_pos || p_ml->i_repeat == REPEAT_ONE)
     {
-        p_ml->i_pos = i_index;
-        p_ml->p_mi = p_ml->i_pos >= 0 ? eina_array_data_get(p_ml->p_item_array, p_ml->i_pos) : NULL;
-        media_list_on_new_pos(p_ml);
+        media_list_select(p_ml, i_index >= 0 ? tree_at(p_ml->p_root, i_index) : NULL);
         return true;
     } else {
         if (p_ml->i_repeat == REPEAT_ALL)
         {
-            p_ml->i_pos = 0;
-            p_ml->p_mi = eina_array_data_get(p_ml->p_item_array, p_ml->i_pos);
-            media_list_on_new_pos(p_ml);
+            media_list_select(p_ml, tree_at(p_ml->p_root, 0));
             return true;
         }
         return false;
@@ -307,12 +863,34 @@ media_list_set_next(media_list *p_ml)
     {
         return media_list_set_pos(p_ml, p_ml->i_pos);
     }
+    else if (p_ml->b_shuffle)
+    {
+        return media_list_shuffle_step(p_ml, true);
+    }
     else
     {
         return media_list_set_pos(p_ml, p_ml->i_pos + 1);
     }
 }
 
+media_item *
+media_list_peek_next(media_list *p_ml)
+{
+    media_list_node *p_node;
+
+    if (p_ml->p_node == NULL)
+        return NULL;
+    if (p_ml->i_repeat == REPEAT_ONE)
+        p_node = p_ml->p_node;
+    else if (p_ml->b_shuffle)
+        p_node = media_list_shuffle_peek(p_ml, true);
+    else if ((unsigned int)p_ml->i_pos + 1 < node_count(p_ml->p_root))
+        p_node = tree_at(p_ml->p_root, p_ml->i_pos + 1);
+    else
+        p_node = p_ml->i_repeat == REPEAT_ALL ? tree_first(p_ml->p_root) : NULL;
+    return p_node != NULL ? p_node->p_mi : NULL;
+}
+
 bool
 media_list_set_prev(media_list *p_ml)
 {
@@ -320,6 +898,10 @@ media_list_set_prev(media_list *p_ml)
     {
         return media_list_set_pos(p_ml, p_ml->i_pos);
     }
+    else if (p_ml->b_shuffle)
+    {
+        return media_list_shuffle_step(p_ml, false);
+    }
     else
     {
         return media_list_set_pos(p_ml, p_ml->i_pos - 1);
@@ -339,11 +921,36 @@ media_list_get_item_at(media_list *p_ml, unsigned int i_index)
 
     ML_CLIP_POS(i_index);
 
-    p_mi = eina_array_data_get(p_ml->p_item_array, i_index);
+    p_mi = media_list_item_at(p_ml, i_index);
     assert(p_mi);
     return p_mi;
 }
 
+media_item *
+media_list_get_writable_item(media_list *p_ml)
+{
+    media_item *p_mi = p_ml->p_mi;
+
+    /* Without a reference of our own, the item can't be replaced */
+    if (p_mi == NULL || !p_ml->b_free_media)
+        return p_mi;
+    p_mi = media_item_writable(p_mi);
+    if (p_mi == NULL)
+    {
+        /* Our reference on the item was kept */
+        return NULL;
+    }
+    if (p_mi != p_ml->p_mi)
+    {
+        media_list_node *p_node = p_ml->p_node;
+        media_list_index_del(p_ml, p_node);
+        p_node->p_mi = p_mi;
+        media_list_index_add(p_ml, p_node);
+        p_ml->p_mi = p_mi;
+    }
+    return p_mi;
+}
+
 void
 media_list_set_repeat_mode(media_list *p_ml, enum PLAYLIST_REPEAT i_repeat)
 {
@@ -356,26 +963,59 @@ media_list_get_repeat_mode(media_list *p_ml)
     return p_ml->i_repeat;
 }
 
+void
+media_list_set_shuffle(media_list *p_ml, bool b_shuffle)
+{
+    if (b_shuffle == p_ml->b_shuffle)
+        return;
+    if (b_shuffle)
+    {
+        if (!media_list_shuffle_reset(p_ml))
+        {
+            LOGE("Can't allocate the shuffle state");
+            return;
+        }
+    }
+    else
+    {
+        free(p_ml->pp_unplayed);
+        p_ml->pp_unplayed = NULL;
+        p_ml->i_unplayed = p_ml->i_unplayed_max = 0;
+    }
+    p_ml->b_shuffle = b_shuffle;
+}
+
+bool
+media_list_get_shuffle(media_list *p_ml)
+{
+    return p_ml->b_shuffle;
+}
+
 // Copy a media list src to a media list dst, removing any previous element in dst.
 int
 media_list_copy_list(media_list *p_ml_src, media_list *p_ml_dst)
 {
-    // Clear the destination
-    media_list_clear(p_ml_dst);
-    //while (media_list_get_count(p_ml_dst) > 0)
-    //    media_list_remove_index(p_ml_dst, 0);
+    unsigned int i_count = node_count(p_ml_src->p_root);
+    media_item **pp_items = NULL;
+    if (i_count > 0)
+    {
+        pp_items = malloc(i_count * sizeof(*pp_items));
+        if (pp_items == NULL)
+            return -1;
+    }
+    unsigned int i = 0;
+    for (media_list_node *p_node = tree_first(p_ml_src->p_root); p_node != NULL; p_node = node_next(p_node))
+        pp_items[i++] = library_item_hold((library_item*)p_node->p_mi);
 
     p_ml_dst->i_repeat = p_ml_src->i_repeat;
 
-    unsigned int items = media_list_get_count(p_ml_src);
-
-    for (int i = 0; i < items; i++)
+    /* The listeners get the whole copy at once */
+    int i_ret = media_list_replace_all(p_ml_dst, pp_items, i_count, p_ml_src->i_pos);
+    if (i_ret != 0)
     {
-        media_item *item = media_list_get_item_at(p_ml_src, i);
-        if (item == NULL)
-            return -1;
-        if (!media_list_insert(p_ml_dst, -1, media_item_copy(item)))
-            return -1;
+        for (i = 0; i < i_count; ++i)
+            media_item_destroy(pp_items[i]);
     }
-    return 0;
+    free(pp_items);
+    return i_ret;
 }
@@ -36,6 +36,13 @@ struct media_list_callbacks
     void (*pf_on_media_added)(media_list *p_ml, void *p_user_data, unsigned int i_pos, media_item *p_mi);
     void (*pf_on_media_removed)(media_list *p_ml, void *p_user_data, unsigned int i_pos, media_item *p_mi);
     void (*pf_on_media_selected)(media_list *p_ml, void *p_user_data, int i_pos, media_item *p_mi);
+    void (*pf_on_media_moved)(media_list *p_ml, void *p_user_data, unsigned int i_from, unsigned int i_to, media_item *p_mi);
+    /* Sent once for a range of items. When they aren't set, the per item
+     * callbacks above are sent for each item instead */
+    void (*pf_on_media_range_added)(media_list *p_ml, void *p_user_data, unsigned int i_pos,
+                                    media_item * const *pp_items, unsigned int i_count);
+    void (*pf_on_media_range_removed)(media_list *p_ml, void *p_user_data, unsigned int i_pos,
+                                      media_item * const *pp_items, unsigned int i_count);
     void *p_user_data;
 };
 
@@ -60,12 +67,31 @@ media_list_unregister_callbacks(media_list *p_ml, media_list_cbs_id *p_id);
 int
 media_list_insert(media_list *p_ml, int i_index, media_item *p_mi);
 
+/* Inserts i_count items at once, at i_index, or at the end if it is negative */
+int
+media_list_insert_range(media_list *p_ml, int i_index, media_item **pp_items, unsigned int i_count);
+
 int
 media_list_remove(media_list *p_ml, media_item *p_mi);
 
+int
+media_list_remove_range(media_list *p_ml, unsigned int i_index, unsigned int i_count);
+
+/* Replaces the whole content of the list, and makes i_pos the current item */
+int
+media_list_replace_all(media_list *p_ml, media_item **pp_items, unsigned int i_count, int i_pos);
+
 int
 media_list_remove_index(media_list *p_ml, unsigned int i_index);
 
+/* Moves the item at i_from so that it ends up at i_to */
+int
+media_list_move(media_list *p_ml, unsigned int i_from, unsigned int i_to);
+
+/* Returns the first position of p_mi, or -1 if it isn't in the list */
+int
+media_list_index_of(media_list *p_ml, media_item *p_mi);
+
 void
 media_list_clear(media_list *p_ml);
 
@@ -81,6 +107,13 @@ media_list_set_pos(media_list *p_ml, int i_index);
 bool
 media_list_set_next(media_list *p_ml);
 
+/*
+ * Returns the item media_list_set_next would move to, or NULL if it would
+ * stop, without moving. In shuffle mode, this draws the next item.
+ */
+media_item *
+media_list_peek_next(media_list *p_ml);
+
 bool
 media_list_set_prev(media_list *p_ml);
 
@@ -90,12 +123,25 @@ media_list_get_item(media_list *p_ml);
 media_item *
 media_list_get_item_at(media_list *p_ml,  unsigned int i_index);
 
+/* Returns the current item, copying it first if it is shared, so that it can
+ * be modified */
+media_item *
+media_list_get_writable_item(media_list *p_ml);
+
 void
 media_list_set_repeat_mode(media_list *p_ml, enum PLAYLIST_REPEAT i_repeat);
 
 enum PLAYLIST_REPEAT
 media_list_get_repeat_mode(media_list *p_ml);
 
+/* In shuffle mode, media_list_set_next/prev walk the items in a random order,
+ * each item being played once per cycle. The list itself isn't reordered */
+void
+media_list_set_shuffle(media_list *p_ml, bool b_shuffle);
+
+bool
+media_list_get_shuffle(media_list *p_ml);
+
 int
 media_list_copy_list(media_list *p_ml_src, media_list *p_ml_dst);
 
@@ -0,0 +1,493 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <Ecore.h>
+
+#include "queue_store.h"
+#include "system_storage.h"
+
+/*
+ * File layout, in native byte order:
+ * - header: magic, version, item count, current position, playback time in ms,
+ *   and size of the records
+ * - for each item, in queue order: a checksum of the rest of the record and
+ *   of its index (32 bits), its media library ID (32 bits), its
+ *   MEDIA_ITEM_TYPE (8 bits), and its path, as a 16 bits length followed by
+ *   the characters, without the trailing \0.
+ * Position and time updates only rewrite their header fields. Other changes
+ * rewrite the records from the first changed one, so that appending to the
+ * queue doesn't rewrite it. The header is written last, and the file is
+ * loaded up to its first record that doesn't match its checksum. Before
+ * records are overwritten, the header is cut down to the ones that are kept,
+ * so that a crash in the middle of the rewrite can't leave a header
+ * describing a mix of old and new records.
+ */
+#define QUEUE_STORE_MAGIC 0x51434c56 /* "VLCQ" */
+#define QUEUE_STORE_VERSION 1
+#define QUEUE_STORE_RECORD_SIZE 11  /* Without the path */
+#define QUEUE_STORE_TIME_STEP 5.0   /* in seconds */
+
+typedef struct queue_store_header
+{
+    uint32_t i_magic;
+    uint32_t i_version;
+    uint32_t i_count;
+    int32_t i_pos;
+    uint32_t i_time;        /* in ms */
+    uint32_t i_data_size;   /* Size of the records */
+} queue_store_header;
+
+struct queue_store
+{
+    int i_fd;
+    media_list *p_ml;
+    media_list_cbs_id *p_cbs_id;
+    queue_store_header header;
+
+    /* Offset of each record from the end of the header, then the end of the
+     * last record. Only up to p_offsets[i_dirty] match the list */
+    uint32_t *p_offsets;
+    unsigned int i_offsets_max;
+    unsigned int i_dirty;   /* First record to write */
+    bool b_dirty;
+    bool b_failed;
+    Ecore_Job *p_flush_job;
+
+    double i_saved_time;
+};
+
+static bool
+queue_store_write(queue_store *p_qs, const void *p_data, size_t i_size, off_t i_offset)
+{
+    while (i_size > 0)
+    {
+        ssize_t i_written = pwrite(p_qs->i_fd, p_data, i_size, i_offset);
+        if (i_written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOGE("Failed to save the play queue: %s", strerror(errno));
+            return false;
+        }
+        p_data = (const uint8_t *)p_data + i_written;
+        i_size -= i_written;
+        i_offset += i_written;
+    }
+    return true;
+}
+
+#define WRITE_HEADER_FIELDS(p_qs, first, last) \
+    queue_store_write(p_qs, &(p_qs)->header.first, \
+            offsetof(queue_store_header, last) + sizeof((p_qs)->header.last) - offsetof(queue_store_header, first), \
+            offsetof(queue_store_header, first))
+
+/* Leaves an empty queue behind, rather than one that doesn't match the list */
+static void
+queue_store_fail(queue_store *p_qs)
+{
+    LOGE("Giving up on saving the play queue");
+    p_qs->b_failed = true;
+    p_qs->header.i_count = 0;
+    p_qs->header.i_pos = -1;
+    p_qs->header.i_data_size = 0;
+    if (ftruncate(p_qs->i_fd, sizeof(p_qs->header)) == 0)
+        WRITE_HEADER_FIELDS(p_qs, i_magic, i_data_size);
+}
+
+static bool
+queue_store_reserve(queue_store *p_qs, unsigned int i_count)
+{
+    if (i_count < p_qs->i_offsets_max)
+        return true;
+    unsigned int i_max = p_qs->i_offsets_max * 2;
+    if (i_max <= i_count)
+        i_max = i_count + 1;
+    uint32_t *p_offsets = realloc(p_qs->p_offsets, i_max * sizeof(*p_offsets));
+    if (p_offsets == NULL)
+        return false;
+    p_qs->p_offsets = p_offsets;
+    p_qs->i_offsets_max = i_max;
+    return true;
+}
+
+#define WRITE_VALUE(buf, type, value) \
+    do { type v = (value); eina_binbuf_append_length(buf, (const unsigned char *)&v, sizeof(v)); } while(0)
+
+/* FNV-1a */
+static uint32_t
+checksum_update(uint32_t i_sum, const void *p_data, size_t i_size)
+{
+    const uint8_t *p_bytes = p_data;
+    for (size_t i = 0; i < i_size; ++i)
+        i_sum = (i_sum ^ p_bytes[i]) * 16777619u;
+    return i_sum;
+}
+
+/* The index is part of the checksum, so that a record that is intact but
+ * at another index than it was written for is rejected too */
+static uint32_t
+record_checksum(uint32_t i_index, uint32_t i_id, uint8_t i_type, uint16_t i_len, const char *psz_path)
+{
+    uint32_t i_sum = 2166136261u;
+    i_sum = checksum_update(i_sum, &i_index, sizeof(i_index));
+    i_sum = checksum_update(i_sum, &i_id, sizeof(i_id));
+    i_sum = checksum_update(i_sum, &i_type, sizeof(i_type));
+    i_sum = checksum_update(i_sum, &i_len, sizeof(i_len));
+    return checksum_update(i_sum, psz_path, i_len);
+}
+
+static void
+write_record(Eina_Binbuf *p_buf, unsigned int i_index, const media_item *p_mi)
+{
+    size_t i_len = strlen(p_mi->psz_path);
+    if (i_len > UINT16_MAX)
+        i_len = UINT16_MAX;
+    WRITE_VALUE(p_buf, uint32_t, record_checksum(i_index, p_mi->i_id, p_mi->i_type, i_len, p_mi->psz_path));
+    WRITE_VALUE(p_buf, uint32_t, p_mi->i_id);
+    WRITE_VALUE(p_buf, uint8_t, p_mi->i_type);
+    WRITE_VALUE(p_buf, uint16_t, i_len);
+    eina_binbuf_append_length(p_buf, (const unsigned char *)p_mi->psz_path, i_len);
+}
+
+static void
+queue_store_flush(queue_store *p_qs)
+{
+    if (!p_qs->b_dirty || p_qs->b_failed)
+        return;
+    p_qs->b_dirty = false;
+
+    unsigned int i_count = media_list_get_count(p_qs->p_ml);
+    Eina_Binbuf *p_buf = eina_binbuf_new();
+    if (p_buf == NULL || !queue_store_reserve(p_qs, i_count))
+    {
+        if (p_buf != NULL)
+            eina_binbuf_free(p_buf);
+        queue_store_fail(p_qs);
+        return;
+    }
+
+    uint32_t i_offset = p_qs->p_offsets[p_qs->i_dirty];
+    /* Appended records are only loaded once the header counts them, but
+     * overwritten ones must stop being counted before they are touched */
+    bool b_overwrite = p_qs->i_dirty < p_qs->header.i_count;
+    bool b_ok = true;
+    if (b_overwrite)
+    {
+        p_qs->header.i_count = p_qs->i_dirty;
+        p_qs->header.i_data_size = i_offset;
+        b_ok = WRITE_HEADER_FIELDS(p_qs, i_count, i_data_size) && fdatasync(p_qs->i_fd) == 0;
+    }
+
+    for (unsigned int i = p_qs->i_dirty; i < i_count; ++i)
+    {
+        p_qs->p_offsets[i] = i_offset + eina_binbuf_length_get(p_buf);
+        write_record(p_buf, i, media_list_get_item_at(p_qs->p_ml, i));
+    }
+    uint32_t i_end = i_offset + eina_binbuf_length_get(p_buf);
+    p_qs->p_offsets[i_count] = i_end;
+    p_qs->i_dirty = i_count;
+
+    if (b_ok)
+        b_ok = queue_store_write(p_qs, eina_binbuf_string_get(p_buf), eina_binbuf_length_get(p_buf),
+                                 sizeof(p_qs->header) + i_offset);
+    eina_binbuf_free(p_buf);
+    if (b_ok && b_overwrite)
+    {
+        /* The checksums can't tell the new records from old ones that were
+         * at the same index, those have to be on disk before the header */
+        b_ok = ftruncate(p_qs->i_fd, sizeof(p_qs->header) + i_end) == 0 &&
+               fdatasync(p_qs->i_fd) == 0;
+    }
+
+    p_qs->header.i_count = i_count;
+    p_qs->header.i_pos = media_list_get_pos(p_qs->p_ml);
+    p_qs->header.i_data_size = i_end;
+    if (!b_ok || !WRITE_HEADER_FIELDS(p_qs, i_count, i_data_size))
+        queue_store_fail(p_qs);
+}
+
+static void
+queue_store_flush_cb(void *data)
+{
+    queue_store *p_qs = data;
+
+    p_qs->p_flush_job = NULL;
+    queue_store_flush(p_qs);
+}
+
+/* Records from i_index on are rewritten once the current changes are done */
+static void
+queue_store_invalidate(queue_store *p_qs, unsigned int i_index)
+{
+    if (p_qs->b_failed)
+        return;
+    if (i_index < p_qs->i_dirty)
+        p_qs->i_dirty = i_index;
+    p_qs->b_dirty = true;
+    if (p_qs->p_flush_job == NULL)
+        p_qs->p_flush_job = ecore_job_add(queue_store_flush_cb, p_qs);
+}
+
+static void
+queue_store_on_range_added(media_list *p_ml, void *p_user_data, unsigned int i_pos,
+                           media_item * const *pp_items, unsigned int i_count)
+{
+    queue_store_invalidate(p_user_data, i_pos);
+}
+
+static void
+queue_store_on_range_removed(media_list *p_ml, void *p_user_data, unsigned int i_pos,
+                             media_item * const *pp_items, unsigned int i_count)
+{
+    queue_store_invalidate(p_user_data, i_pos);
+}
+
+static void
+queue_store_on_media_moved(media_list *p_ml, void *p_user_data, unsigned int i_from, unsigned int i_to,
+                           media_item *p_mi)
+{
+    queue_store_invalidate(p_user_data, i_from < i_to ? i_from : i_to);
+}
+
+static void
+queue_store_on_media_selected(media_list *p_ml, void *p_user_data, int i_pos, media_item *p_mi)
+{
+    queue_store *p_qs = p_user_data;
+
+    if (p_qs->b_failed)
+        return;
+    p_qs->header.i_pos = i_pos;
+    p_qs->header.i_time = 0;
+    p_qs->i_saved_time = 0.0;
+    if (!WRITE_HEADER_FIELDS(p_qs, i_pos, i_time))
+        queue_store_fail(p_qs);
+}
+
+static void
+queue_store_reset(queue_store *p_qs)
+{
+    p_qs->header = (queue_store_header) {
+        .i_magic = QUEUE_STORE_MAGIC,
+        .i_version = QUEUE_STORE_VERSION,
+        .i_pos = -1,
+    };
+    p_qs->p_offsets[0] = 0;
+    p_qs->i_dirty = 0;
+    if (ftruncate(p_qs->i_fd, 0) != 0 || !WRITE_HEADER_FIELDS(p_qs, i_magic, i_data_size))
+        queue_store_fail(p_qs);
+}
+
+/* Returns the number of restored items */
+static unsigned int
+queue_store_load(queue_store *p_qs, media_list *p_ml)
+{
+    struct stat st;
+    if (fstat(p_qs->i_fd, &st) != 0 || (size_t)st.st_size < sizeof(p_qs->header))
+    {
+        queue_store_reset(p_qs);
+        return 0;
+    }
+    const uint8_t *p_data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, p_qs->i_fd, 0);
+    if (p_data == MAP_FAILED)
+    {
+        queue_store_reset(p_qs);
+        return 0;
+    }
+    memcpy(&p_qs->header, p_data, sizeof(p_qs->header));
+    if (p_qs->header.i_magic != QUEUE_STORE_MAGIC || p_qs->header.i_version != QUEUE_STORE_VERSION)
+    {
+        munmap((void *)p_data, st.st_size);
+        queue_store_reset(p_qs);
+        return 0;
+    }
+
+    const uint8_t *p_records = p_data + sizeof(p_qs->header);
+    size_t i_size = st.st_size - sizeof(p_qs->header);
+    if (p_qs->header.i_data_size < i_size)
+        i_size = p_qs->header.i_data_size;
+    unsigned int i_max = p_qs->header.i_count;
+    if (i_max > i_size / QUEUE_STORE_RECORD_SIZE)
+        i_max = i_size / QUEUE_STORE_RECORD_SIZE;
+
+    media_item **pp_items = malloc(i_max * sizeof(*pp_items));
+    if ((pp_items == NULL && i_max > 0) || !queue_store_reserve(p_qs, i_max))
+    {
+        free(pp_items);
+        munmap((void *)p_data, st.st_size);
+        queue_store_reset(p_qs);
+        return 0;
+    }
+
+    uint32_t i_offset = 0;
+    unsigned int i_count = 0;
+    while (i_count < i_max && i_size - i_offset >= QUEUE_STORE_RECORD_SIZE)
+    {
+        const uint8_t *p_record = p_records + i_offset;
+        uint32_t i_sum, i_id;
+        uint8_t i_type;
+        uint16_t i_len;
+        memcpy(&i_sum, p_record, sizeof(i_sum));
+        memcpy(&i_id, p_record + 4, sizeof(i_id));
+        memcpy(&i_type, p_record + 8, sizeof(i_type));
+        memcpy(&i_len, p_record + 9, sizeof(i_len));
+        if (i_len == 0 || i_size - i_offset - QUEUE_STORE_RECORD_SIZE < i_len)
+            break;
+        const char *psz_record_path = (const char *)p_record + QUEUE_STORE_RECORD_SIZE;
+        if (record_checksum(i_count, i_id, i_type, i_len, psz_record_path) != i_sum)
+            break;
+        const char *psz_path = eina_stringshare_add_length(psz_record_path, i_len);
+        media_item *p_mi = psz_path != NULL ? media_item_create(psz_path, (enum MEDIA_ITEM_TYPE)i_type) : NULL;
+        eina_stringshare_del(psz_path);
+        if (p_mi == NULL)
+            break;
+        p_mi->i_id = i_id;
+        p_qs->p_offsets[i_count] = i_offset;
+        pp_items[i_count++] = p_mi;
+        i_offset += QUEUE_STORE_RECORD_SIZE + i_len;
+    }
+    p_qs->p_offsets[i_count] = i_offset;
+    p_qs->i_dirty = i_count;
+    munmap((void *)p_data, st.st_size);
+
+    int i_pos = p_qs->header.i_pos;
+    if (i_pos >= (int)i_count)
+        i_pos = (int)i_count - 1;
+    if (media_list_replace_all(p_ml, pp_items, i_count, i_pos) != 0)
+    {
+        for (unsigned int i = 0; i < i_count; ++i)
+            media_item_destroy(pp_items[i]);
+        i_count = 0;
+    }
+    free(pp_items);
+
+    /* Drop what couldn't be read */
+    if (i_count != p_qs->header.i_count || i_offset != p_qs->header.i_data_size)
+    {
+        LOGW("Restored %u out of %u queued items", i_count, p_qs->header.i_count);
+        if (i_count == 0)
+            queue_store_reset(p_qs);
+        else
+        {
+            p_qs->header.i_count = i_count;
+            p_qs->header.i_pos = media_list_get_pos(p_ml);
+            p_qs->header.i_data_size = i_offset;
+            if (ftruncate(p_qs->i_fd, sizeof(p_qs->header) + i_offset) != 0 ||
+                !WRITE_HEADER_FIELDS(p_qs, i_magic, i_data_size))
+                queue_store_fail(p_qs);
+        }
+    }
+    return i_count;
+}
+
+queue_store *
+queue_store_open(const char *psz_name)
+{
+    char *psz_appdata = system_storage_appdata_get();
+    if (psz_appdata == NULL)
+        return NULL;
+    char *psz_path;
+    if (asprintf(&psz_path, "%s%s.queue", psz_appdata, psz_name) < 0)
+        psz_path = NULL;
+    free(psz_appdata);
+    if (psz_path == NULL)
+        return NULL;
+
+    queue_store *p_qs = calloc(1, sizeof(*p_qs));
+    if (p_qs == NULL)
+    {
+        free(psz_path);
+        return NULL;
+    }
+    p_qs->i_fd = open(psz_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (p_qs->i_fd < 0)
+        LOGE("Failed to open %s: %s", psz_path, strerror(errno));
+    free(psz_path);
+    if (p_qs->i_fd < 0 || !queue_store_reserve(p_qs, 16))
+    {
+        queue_store_close(p_qs);
+        return NULL;
+    }
+    return p_qs;
+}
+
+void
+queue_store_close(queue_store *p_qs)
+{
+    if (p_qs->p_cbs_id != NULL)
+        media_list_unregister_callbacks(p_qs->p_ml, p_qs->p_cbs_id);
+    if (p_qs->p_flush_job != NULL)
+        ecore_job_del(p_qs->p_flush_job);
+    if (p_qs->p_ml != NULL)
+        queue_store_flush(p_qs);
+    if (p_qs->i_fd >= 0)
+        close(p_qs->i_fd);
+    free(p_qs->p_offsets);
+    free(p_qs);
+}
+
+double
+queue_store_attach(queue_store *p_qs, media_list *p_ml)
+{
+    media_list_callbacks cbs = {
+        .pf_on_media_selected = queue_store_on_media_selected,
+        .pf_on_media_moved = queue_store_on_media_moved,
+        .pf_on_media_range_added = queue_store_on_range_added,
+        .pf_on_media_range_removed = queue_store_on_range_removed,
+        .p_user_data = p_qs,
+    };
+
+    p_qs->p_ml = p_ml;
+    unsigned int i_count = queue_store_load(p_qs, p_ml);
+
+    p_qs->p_cbs_id = media_list_register_callbacks(p_ml, &cbs);
+    if (p_qs->p_cbs_id == NULL)
+        queue_store_fail(p_qs);
+
+    p_qs->i_saved_time = i_count > 0 ? p_qs->header.i_time / 1000.0 : 0.0;
+    return p_qs->i_saved_time;
+}
+
+void
+queue_store_set_time(queue_store *p_qs, double i_time, bool b_force)
+{
+    if (p_qs->b_failed)
+        return;
+    if (!b_force && fabs(i_time - p_qs->i_saved_time) < QUEUE_STORE_TIME_STEP)
+        return;
+    p_qs->i_saved_time = i_time;
+    p_qs->header.i_time = i_time > 0.0 ? (uint32_t)(i_time * 1000.0) : 0;
+    if (!WRITE_HEADER_FIELDS(p_qs, i_time, i_time))
+        queue_store_fail(p_qs);
+}
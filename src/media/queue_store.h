@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+
+#ifndef QUEUE_STORE_H_
+#define QUEUE_STORE_H_
+
+#include <stdbool.h>
+
+#include "media/media_list.h"
+
+/*
+ * Keeps a copy of a media list in the application data directory, so that
+ * the queue, its current item and the playback time survive the application
+ * being killed.
+ * The file is updated as the list changes, and is read back when the store is
+ * attached, without involving the media library.
+ */
+typedef struct queue_store queue_store;
+
+/* Opens the psz_name queue file, creating it if needed */
+queue_store *
+queue_store_open(const char *psz_name);
+
+/* Stops following the list, and writes the pending changes */
+void
+queue_store_close(queue_store *p_qs);
+
+/*
+ * Fills the empty p_ml with the saved queue, then follows its changes.
+ * Returns the playback time saved for the current item, in seconds.
+ */
+double
+queue_store_attach(queue_store *p_qs, media_list *p_ml);
+
+/*
+ * Saves the playback time of the current item. Unless b_force is set, the
+ * time is only written once it moved by a few seconds.
+ */
+void
+queue_store_set_time(queue_store *p_qs, double i_time, bool b_force);
+
+#endif /* QUEUE_STORE_H_ */
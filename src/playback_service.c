@@ -36,12 +36,16 @@
 
 #include "playback_service.h"
 #include "media/media_list.h"
+#include "media/queue_store.h"
 #include "preferences/preferences.h"
 
 #include "ui/views/minicontrol_view.h"
 
 #define PLAYLIST_CONTEXT_COUNT (PLAYLIST_CONTEXT_OTHERS)
 
+/* Time before the end of an audio item at which the next one gets opened */
+#define PS_STANDBY_DELAY 5.0
+
 static const int META_EMOTIOM_TO_MEDIA_ITEM[] = {
     MEDIA_ITEM_META_TITLE,
     MEDIA_ITEM_META_ARTIST,
@@ -65,6 +69,7 @@ struct playback_service
     media_list *p_ml_list[PLAYLIST_CONTEXT_COUNT];
     media_list *p_ml;
     Evas_Object *p_ea;  /* emotion audio */
+    Evas_Object *p_ea_standby;  /* emotion audio, opening the next item */
     Evas_Object *p_ev;  /* emotion video */
     Evas_Object *p_e;   /* emotion audio or video */
     Evas *p_ea_evas;
@@ -83,6 +88,12 @@ struct playback_service
     minicontrol     *p_minicontrol;
     double          i_last_notification_pos;
 
+    const char      *psz_standby_path;  /* Item opened by p_ea_standby, interned */
+    bool            b_standby_ready;
+
+    queue_store     *p_queue_store;     /* Saves the audio queue */
+    double          i_resume_time;      /* Saved time of the restored audio item */
+
     ps_on_emotion_restart   emotion_restart_cb;
     void                    *emotion_restart_cb_data;
 };
@@ -109,6 +120,22 @@ struct playback_service
     } \
 } while(0)
 
+#define PS_SEND_RANGE_CALLBACK(pf_range_cb, pf_cb, i_index, pp_items, i_count) do { \
+    if (p_ps->p_cbs_list) { \
+        Eina_List *p_el, *p_el_next; \
+        playback_service_callbacks *p_cbs; \
+        EINA_LIST_FOREACH_SAFE(p_ps->p_cbs_list, p_el_next, p_el, p_cbs) { \
+            if (p_cbs->i_ctx != p_ps->i_ctx && p_cbs->i_ctx != PLAYLIST_CONTEXT_NONE) \
+                continue; \
+            if (p_cbs->pf_range_cb) \
+                p_cbs->pf_range_cb(p_ps, p_cbs->p_user_data, i_index, pp_items, i_count); \
+            else if (p_cbs->pf_cb) \
+                for (unsigned int i_item = 0; i_item < (i_count); ++i_item) \
+                    p_cbs->pf_cb(p_ps, p_cbs->p_user_data, (i_index) + i_item, (pp_items)[i_item]); \
+        } \
+    } \
+} while(0)
+
 void
 ps_register_on_emotion_restart_cb(playback_service *p_ps, ps_on_emotion_restart func, void *data)
 {
@@ -136,10 +163,15 @@ ps_notification_update_meta(playback_service *p_ps, media_item *p_mi)
     mini_control_cover_set(p_ps->p_minicontrol, p_mi->psz_snapshot);
 }
 
+static void
+ps_standby_prepare(playback_service *p_ps);
+
 static void
 ps_emotion_length_change_cb(void *data, Evas_Object *obj, void *event)
 {
     playback_service *p_ps = data;
+    if (obj != p_ps->p_e)
+        return;
     double i_len = emotion_object_play_length_get(obj);
 
     PS_SEND_CALLBACK(pf_on_new_len, i_len);
@@ -149,6 +181,8 @@ static void
 ps_emotion_position_update_cb(void *data, Evas_Object *obj, void *event)
 {
     playback_service *p_ps = data;
+    if (obj != p_ps->p_e)
+        return;
 
     if (p_ps->b_seeking)
     {
@@ -169,6 +203,12 @@ ps_emotion_position_update_cb(void *data, Evas_Object *obj, void *event)
             mini_control_progress_set(p_ps->p_minicontrol, i_pos);
         }
 
+        if (p_ps->i_ctx == PLAYLIST_CONTEXT_AUDIO && p_ps->p_queue_store != NULL)
+            queue_store_set_time(p_ps->p_queue_store, i_time, false);
+
+        if (p_ps->i_ctx == PLAYLIST_CONTEXT_AUDIO && i_len > 0.0 && i_len - i_time < PS_STANDBY_DELAY)
+            ps_standby_prepare(p_ps);
+
         PS_SEND_CALLBACK(pf_on_new_time, i_time, i_pos);
     }
 }
@@ -177,14 +217,27 @@ static void
 ps_emotion_play_started_cb(void *data, Evas_Object *obj, void *event)
 {
     playback_service *p_ps = data;
+    if (obj != p_ps->p_e)
+        return;
     media_item *p_mi = media_list_get_item(p_ps->p_ml);
     const char *meta;
+    bool b_writable = false;
 
     for (unsigned int i = 0; i < EMOTION_META_INFO_TRACK_COUNT; ++i)
     {
         meta = emotion_object_meta_info_get(obj, i);
-        if (meta != NULL)
-            media_item_set_meta(p_mi, META_EMOTIOM_TO_MEDIA_ITEM[i], meta);
+        if (meta == NULL)
+            continue;
+        /* The item is likely shared with the list it was started from */
+        if (!b_writable)
+        {
+            media_item *p_writable_mi = media_list_get_writable_item(p_ps->p_ml);
+            if (p_writable_mi == NULL)
+                break;
+            p_mi = p_writable_mi;
+            b_writable = true;
+        }
+        media_item_set_meta(p_mi, META_EMOTIOM_TO_MEDIA_ITEM[i], meta);
     }
 
     PS_SEND_CALLBACK(pf_on_started, p_mi);
@@ -210,6 +263,8 @@ static void
 ps_emotion_play_finished_cb(void *data, Evas_Object *obj, void *event)
 {
     playback_service *p_ps = data;
+    if (obj != p_ps->p_e)
+        return;
 
     LOGD("ps_emotion_play_finished_cb");
 
@@ -236,6 +291,24 @@ ml_on_media_removed_cb(media_list *p_ml, void *p_user_data, unsigned int i_pos,
     PS_SEND_CALLBACK(pf_on_media_removed, i_pos, p_mi);
 }
 
+static void
+ml_on_media_range_added_cb(media_list *p_ml, void *p_user_data, unsigned int i_pos,
+                           media_item * const *pp_items, unsigned int i_count)
+{
+    playback_service *p_ps = p_user_data;
+
+    PS_SEND_RANGE_CALLBACK(pf_on_media_range_added, pf_on_media_added, i_pos, pp_items, i_count);
+}
+
+static void
+ml_on_media_range_removed_cb(media_list *p_ml, void *p_user_data, unsigned int i_pos,
+                             media_item * const *pp_items, unsigned int i_count)
+{
+    playback_service *p_ps = p_user_data;
+
+    PS_SEND_RANGE_CALLBACK(pf_on_media_range_removed, pf_on_media_removed, i_pos, pp_items, i_count);
+}
+
 static void
 ml_on_media_selected_cb(media_list *p_ml, void *p_user_data, int i_pos,
                         media_item *p_mi)
@@ -244,6 +317,9 @@ ml_on_media_selected_cb(media_list *p_ml, void *p_user_data, int i_pos,
     if (p_ml != p_ps->p_ml)
         return;
 
+    /* The saved time was the one of the previous item */
+    p_ps->i_resume_time = 0.0;
+
     if (p_ps->b_started)
     {
         LOGD("ml_on_media_selected_cb: %d", i_pos);
@@ -319,6 +395,80 @@ ps_emotion_destroy(playback_service *p_ps, Evas_Object *p_e)
     evas_object_del(p_e);
 }
 
+static void
+ps_standby_release(playback_service *p_ps)
+{
+    if (p_ps->psz_standby_path == NULL)
+        return;
+    if (p_ps->p_ea_standby)
+        emotion_object_file_set(p_ps->p_ea_standby, NULL);
+    eina_stringshare_del(p_ps->psz_standby_path);
+    p_ps->psz_standby_path = NULL;
+    p_ps->b_standby_ready = false;
+}
+
+/*
+ * Opens the item that follows the current one on the standby emotion object,
+ * so that it can be swapped in as soon as the current one ends. It stays
+ * paused at its start until then.
+ */
+static void
+ps_standby_prepare(playback_service *p_ps)
+{
+    media_item *p_next = media_list_peek_next(p_ps->p_ml);
+
+    /* Paths are interned. A failed item isn't tried again */
+    if (p_next == NULL || p_next->psz_path == NULL || p_next->psz_path == p_ps->psz_standby_path)
+        return;
+    ps_standby_release(p_ps);
+    p_ps->psz_standby_path = eina_stringshare_ref(p_next->psz_path);
+
+    if (!p_ps->p_ea_standby)
+    {
+        /* Same settings as p_ea, which it replaces */
+        p_ps->p_ea_standby = ps_emotion_create(p_ps, p_ps->p_ea_evas, true);
+        if (!p_ps->p_ea_standby)
+            return;
+    }
+    LOGD("Opening the next item: %s", p_next->psz_path);
+    p_ps->b_standby_ready = emotion_object_file_set(p_ps->p_ea_standby, p_next->psz_path);
+    if (!p_ps->b_standby_ready)
+        LOGE("emotion_object_file_set failed on the standby object");
+}
+
+/* Carries the settings of the playing emotion object over to the one that
+ * replaces it, as if the next item had been opened on the same object */
+static void
+ps_emotion_copy_settings(Evas_Object *p_from, Evas_Object *p_to)
+{
+    emotion_object_play_speed_set(p_to, emotion_object_play_speed_get(p_from));
+    emotion_object_audio_volume_set(p_to, emotion_object_audio_volume_get(p_from));
+    emotion_object_audio_mute_set(p_to, emotion_object_audio_mute_get(p_from));
+    emotion_object_audio_channel_set(p_to, emotion_object_audio_channel_get(p_from));
+    emotion_object_spu_channel_set(p_to, emotion_object_spu_channel_get(p_from));
+}
+
+/* Swaps the standby emotion object in, if it opened p_mi */
+static bool
+ps_standby_take(playback_service *p_ps, media_item *p_mi)
+{
+    if (!p_ps->b_standby_ready || p_ps->p_e != p_ps->p_ea || p_mi->psz_path != p_ps->psz_standby_path)
+    {
+        ps_standby_release(p_ps);
+        return false;
+    }
+    Evas_Object *p_e = p_ps->p_ea;
+    ps_emotion_copy_settings(p_e, p_ps->p_ea_standby);
+    p_ps->p_ea = p_ps->p_e = p_ps->p_ea_standby;
+    p_ps->p_ea_standby = p_e;
+    emotion_object_file_set(p_e, NULL);
+
+    eina_stringshare_del(p_ps->psz_standby_path);
+    p_ps->psz_standby_path = NULL;
+    p_ps->b_standby_ready = false;
+    return true;
+}
+
 static media_list *
 get_media_list(playback_service *p_ps, enum PLAYLIST_CONTEXT i_ctx)
 {
@@ -342,6 +492,8 @@ playback_service_create(application *p_app)
                 .pf_on_media_added = ml_on_media_added_cb,
                 .pf_on_media_removed = ml_on_media_removed_cb,
                 .pf_on_media_selected = ml_on_media_selected_cb,
+                .pf_on_media_range_added = ml_on_media_range_added_cb,
+                .pf_on_media_range_removed = ml_on_media_range_removed_cb,
                 .p_user_data = p_ps,
         };
         p_ps->p_ml_list[i] = media_list_create(true);
@@ -354,6 +506,12 @@ playback_service_create(application *p_app)
     p_ps->i_ctx = PLAYLIST_CONTEXT_AUDIO;
     p_ps->p_ml = get_media_list(p_ps, p_ps->i_ctx);
 
+    /* Restore the audio queue of the previous run */
+    p_ps->p_queue_store = queue_store_open("audio");
+    if (p_ps->p_queue_store)
+        p_ps->i_resume_time = queue_store_attach(p_ps->p_queue_store,
+                                                 get_media_list(p_ps, PLAYLIST_CONTEXT_AUDIO));
+
     p_ps->p_ea_evas = evas_new();
     if (p_ps->p_ea_evas)
     {
@@ -377,6 +535,10 @@ playback_service_destroy(playback_service *p_ps)
     Eina_List *p_el;
     void *p_id;
 
+    /* Before the lists get cleared */
+    if (p_ps->p_queue_store)
+        queue_store_close(p_ps->p_queue_store);
+
     for (unsigned int i = 0; i < PLAYLIST_CONTEXT_COUNT; ++i)
     {
         if (p_ps->p_ml_list[i])
@@ -391,6 +553,9 @@ playback_service_destroy(playback_service *p_ps)
         eina_list_free(p_ps->p_cbs_list);
     }
 
+    ps_standby_release(p_ps);
+    if (p_ps->p_ea_standby)
+        ps_emotion_destroy(p_ps, p_ps->p_ea_standby);
     if (p_ps->p_ea)
         ps_emotion_destroy(p_ps, p_ps->p_ea);
     if (p_ps->p_ev)
@@ -412,6 +577,12 @@ playback_service_force_restart_emotion(playback_service *p_ps)
     playback_service_stop_notify(p_ps, true);
 
     p_ps->p_e = NULL;
+    ps_standby_release(p_ps);
+    if (p_ps->p_ea_standby)
+    {
+        ps_emotion_destroy(p_ps, p_ps->p_ea_standby);
+        p_ps->p_ea_standby = NULL;
+    }
     if (p_ps->p_ea)
     {
         ps_emotion_destroy(p_ps, p_ps->p_ea);
@@ -632,18 +803,29 @@ playback_service_start(playback_service *p_ps, double i_time)
     }
     LOGD("playback_service_start: %s", p_mi->psz_path);
 
-    // Unset the current file. Because emotion_object_file_set returns EINA_FALSE
-    // when reloading the same file, we need to unset it first to allow the REPEAT_ONE
-    // function to work.
-    emotion_object_file_set(p_ps->p_e, NULL);
-
-    if (!emotion_object_file_set(p_ps->p_e, p_mi->psz_path))
+    if (ps_standby_take(p_ps, p_mi))
     {
-        LOGE("emotion_object_file_set failed");
-        return -1;
+        /* Already opened: its length won't change anymore */
+        double i_len = emotion_object_play_length_get(p_ps->p_e);
+        if (i_len > 0.0)
+            PS_SEND_CALLBACK(pf_on_new_len, i_len);
+    }
+    else
+    {
+        // Unset the current file. Because emotion_object_file_set returns EINA_FALSE
+        // when reloading the same file, we need to unset it first to allow the REPEAT_ONE
+        // function to work.
+        emotion_object_file_set(p_ps->p_e, NULL);
+
+        if (!emotion_object_file_set(p_ps->p_e, p_mi->psz_path))
+        {
+            LOGE("emotion_object_file_set failed");
+            return -1;
+        }
     }
     if (i_time > 0)
         emotion_object_position_set(p_ps->p_e, i_time);
+    p_ps->i_resume_time = 0.0;
 
     i_new_lock = p_ps->p_e == p_ps->p_ev ? POWER_LOCK_DISPLAY : POWER_LOCK_CPU;
 
@@ -667,6 +849,7 @@ playback_service_stop_notify(playback_service *p_ps, bool b_notify)
 
     playback_service_pause(p_ps);
     emotion_object_file_set(p_ps->p_e, NULL);
+    ps_standby_release(p_ps);
     p_ps->b_started = false;
     ps_release_lock(p_ps);
 
@@ -718,6 +901,8 @@ playback_service_pause(playback_service *p_ps)
         return -1;
 
     emotion_object_play_set(p_ps->p_e, false);
+    if (p_ps->i_ctx == PLAYLIST_CONTEXT_AUDIO && p_ps->p_queue_store != NULL)
+        queue_store_set_time(p_ps->p_queue_store, emotion_object_position_get(p_ps->p_e), true);
     PS_SEND_CALLBACK(pf_on_playpause, false);
     mini_control_playing_set(p_ps->p_minicontrol, EINA_FALSE);
     return 0;
@@ -728,7 +913,12 @@ playback_service_toggle_play_pause(playback_service *p_ps)
 {
     bool b_new_state;
     if (!p_ps->b_started)
-        return false;
+    {
+        /* Resume the audio queue restored from the previous run */
+        if (p_ps->i_ctx != PLAYLIST_CONTEXT_AUDIO)
+            return false;
+        return playback_service_start(p_ps, p_ps->i_resume_time) == 0;
+    }
 
     b_new_state = !emotion_object_play_get(p_ps->p_e);
     emotion_object_play_set(p_ps->p_e, b_new_state);
@@ -830,12 +1020,30 @@ playback_service_list_insert(playback_service *p_ps, int i_index, media_item *p_
     return media_list_insert(p_ps->p_ml, i_index, p_mi);
 }
 
+int
+playback_service_list_insert_range(playback_service *p_ps, int i_index, media_item **pp_items, unsigned int i_count)
+{
+    return media_list_insert_range(p_ps->p_ml, i_index, pp_items, i_count);
+}
+
 int
 playback_service_list_remove(playback_service *p_ps, media_item *p_mi)
 {
     return media_list_remove(p_ps->p_ml, p_mi);
 }
 
+int
+playback_service_list_remove_range(playback_service *p_ps, unsigned int i_index, unsigned int i_count)
+{
+    return media_list_remove_range(p_ps->p_ml, i_index, i_count);
+}
+
+int
+playback_service_list_replace_all(playback_service *p_ps, media_item **pp_items, unsigned int i_count, int i_pos)
+{
+    return media_list_replace_all(p_ps->p_ml, pp_items, i_count, i_pos);
+}
+
 int
 playback_service_list_remove_index(playback_service *p_ps, unsigned int i_index)
 {
@@ -946,6 +1154,18 @@ playback_service_get_repeat_mode(playback_service *p_ps)
     return media_list_get_repeat_mode(get_media_list(p_ps, PLAYLIST_CONTEXT_AUDIO));
 }
 
+void
+playback_service_set_shuffle(playback_service *p_ps, bool b_shuffle)
+{
+    media_list_set_shuffle(get_media_list(p_ps, PLAYLIST_CONTEXT_AUDIO), b_shuffle);
+}
+
+bool
+playback_service_get_shuffle(playback_service *p_ps)
+{
+    return media_list_get_shuffle(get_media_list(p_ps, PLAYLIST_CONTEXT_AUDIO));
+}
+
 double
 playback_service_get_play_speed(playback_service *p_ps)
 {
@@ -966,9 +1186,9 @@ playback_service_enable_background_playback(playback_service *p_ps)
 
     double time = playback_service_get_time(p_ps);
 
-    if (!media_list_copy_list(get_media_list(p_ps, PLAYLIST_CONTEXT_VIDEO), get_media_list(p_ps, PLAYLIST_CONTEXT_AUDIO)))
+    if (media_list_copy_list(get_media_list(p_ps, PLAYLIST_CONTEXT_VIDEO), get_media_list(p_ps, PLAYLIST_CONTEXT_AUDIO)) != 0)
         LOGE("Copying video playlist to audio failed");
-    if (!playback_service_set_context(p_ps, PLAYLIST_CONTEXT_AUDIO))
+    if (playback_service_set_context(p_ps, PLAYLIST_CONTEXT_AUDIO) != 0)
         LOGE("Switching from video context to audio failed");
 
     playback_service_start(p_ps, time);
@@ -43,6 +43,12 @@ struct playback_service_callbacks
     void (*pf_on_media_added)(playback_service *p_ps, void *p_user_data, unsigned int i_pos, media_item *p_mi);
     void (*pf_on_media_removed)(playback_service *p_ps, void *p_user_data, unsigned int i_pos, media_item *p_mi);
     void (*pf_on_media_selected)(playback_service *p_ps, void *p_user_data, unsigned int i_pos, media_item *p_mi);
+    /* Sent once for a range of items, instead of pf_on_media_added/removed
+     * for each of them */
+    void (*pf_on_media_range_added)(playback_service *p_ps, void *p_user_data, unsigned int i_pos,
+                                    media_item * const *pp_items, unsigned int i_count);
+    void (*pf_on_media_range_removed)(playback_service *p_ps, void *p_user_data, unsigned int i_pos,
+                                      media_item * const *pp_items, unsigned int i_count);
     void (*pf_on_started)(playback_service *p_ps, void *p_user_data, media_item *p_mi);
     void (*pf_on_playpause)(playback_service *p_ps, void *p_user_data, bool b_playing);
     void (*pf_on_stopped)(playback_service *p_ps, void *p_user_data);
@@ -139,9 +145,18 @@ playback_service_list_append(playback_service *p_ps, media_item *p_mi)
     return playback_service_list_insert(p_ps, -1, p_mi);
 }
 
+int
+playback_service_list_insert_range(playback_service *p_ps, int i_index, media_item **pp_items, unsigned int i_count);
+
 int
 playback_service_list_remove(playback_service *p_ps, media_item *p_mi);
 
+int
+playback_service_list_remove_range(playback_service *p_ps, unsigned int i_index, unsigned int i_count);
+
+int
+playback_service_list_replace_all(playback_service *p_ps, media_item **pp_items, unsigned int i_count, int i_pos);
+
 int
 playback_service_list_remove_index(playback_service *p_ps, unsigned int i_index);
 
@@ -190,6 +205,12 @@ playback_service_set_repeat_mode(playback_service *p_ps, enum PLAYLIST_REPEAT i_
 enum PLAYLIST_REPEAT
 playback_service_get_repeat_mode(playback_service *p_ps);
 
+void
+playback_service_set_shuffle(playback_service *p_ps, bool b_shuffle);
+
+bool
+playback_service_get_shuffle(playback_service *p_ps);
+
 double
 playback_service_get_play_speed(playback_service *p_ps);
 
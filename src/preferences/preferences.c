@@ -51,6 +51,7 @@ pref_key_id_map mapping[] =
         // type index
         {{.t_index = PREF_SUBSENC}, "SUBSENC"},
         {{.t_index = PREF_CURRENT_VIEW}, "CURRENT_VIEW"},
+        {{.t_index = PREF_ARTWORK_CACHE_SIZE}, "ARTWORK_CACHE_SIZE"},
 
         // type bool
         {{.t_bool = PREF_FRAME_SKIP}, "FRAME_SKIP"},
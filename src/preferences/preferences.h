@@ -30,6 +30,10 @@
 #include "common.h"
 #include "ui/settings/menu_id.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct preferences preferences;
 
 typedef enum pref_enum {
@@ -41,6 +45,7 @@ typedef enum pref_enum {
 typedef enum pref_index {
     PREF_SUBSENC = 2000,
     PREF_CURRENT_VIEW,
+    PREF_ARTWORK_CACHE_SIZE,
 } pref_index;
 
 typedef enum pref_bool {
@@ -72,4 +77,8 @@ preferences_get_bool(pref_bool key, bool default_value);
 char *
 preferences_get_libvlc_options();
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
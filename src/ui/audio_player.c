@@ -28,18 +28,20 @@
 
 #include <Elementary.h>
 #include <math.h>
+#include <limits.h>
 
 #include "playback_service.h"
 #include "interface.h"
 #include "audio_player.h"
 #include "ui/utils.h"
+#include "media/artwork.h"
 
 struct audio_player {
     interface *intf;
     playback_service *p_ps;
     playback_service_cbs_id *p_ps_cbs_id;
 
-    bool save_state, shuffle_state, playlist_state, more_state, fs_state;
+    bool save_state, playlist_state, more_state, fs_state;
     double slider_event_time;
 
 
@@ -353,7 +355,6 @@ audio_player_reset_states(audio_player *mpd)
 {
     mpd->fs_state = false;
     mpd->save_state = false;
-    mpd->shuffle_state = false;
     mpd->playlist_state = false;
     mpd->more_state = false;
 }
@@ -383,7 +384,7 @@ bool
 audio_player_shuffle_state(audio_player *mpd)
 {
     /* Return the current shuffle state*/
-    return mpd->shuffle_state;
+    return playback_service_get_shuffle(mpd->p_ps);
 }
 
 bool
@@ -458,8 +459,13 @@ update_player_cover_display(audio_player* mpd, const char *path)
 
     if (path)
     {
-        elm_object_part_content_set(mpd->layout, "swallow.cover", create_image(mpd->layout, path));
-        elm_object_part_content_set(mpd->fs_layout, "cover", create_image(mpd->fs_layout, path));
+        /* path is the list icon, use the variants scaled for each cover */
+        char psz_buf[PATH_MAX];
+        artwork_mark_used(path);
+        elm_object_part_content_set(mpd->layout, "swallow.cover", create_image(mpd->layout,
+                artwork_variant_path(path, ARTWORK_COVER, psz_buf, sizeof(psz_buf))));
+        elm_object_part_content_set(mpd->fs_layout, "cover", create_image(mpd->fs_layout,
+                artwork_variant_path(path, ARTWORK_FULLSCREEN, psz_buf, sizeof(psz_buf))));
     }
     else
     {
@@ -746,8 +752,8 @@ fs_shuffle_player_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
         /* */
         evas_object_show(mpd->fs_shuffle_btn);
 
-        /* Update the shuffle button state of the player */
-        mpd->shuffle_state = true;
+        /* Play the list in a random order */
+        playback_service_set_shuffle(mpd->p_ps, true);
     }
     else
     {
@@ -756,8 +762,8 @@ fs_shuffle_player_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
         /* */
         evas_object_show(mpd->fs_shuffle_btn);
 
-        /* Update the shuffle button state of the player */
-        mpd->shuffle_state = false;
+        /* Play the list in order */
+        playback_service_set_shuffle(mpd->p_ps, false);
     }
 }
 
@@ -908,7 +914,7 @@ add_fullscreen_item_table(audio_player *mpd, Evas_Object *parent)
     elm_object_part_content_set(layout, "repeat_button", mpd->fs_repeat_btn);
 
     /* Shuffle */
-    if (mpd->shuffle_state == FALSE){
+    if (audio_player_shuffle_state(mpd) == false){
         mpd->fs_shuffle_btn = create_icon(parent, "ic_shuffle_normal.png");
     }
     else {
@@ -1011,20 +1017,10 @@ audio_player_start(audio_player *mpd, Eina_Array *array, int pos)
     audio_player_reset_states(mpd);
 
     playback_service_set_context(mpd->p_ps, PLAYLIST_CONTEXT_AUDIO);
-    playback_service_list_clear(mpd->p_ps);
-
-    media_item *p_mi;
-    Eina_Array_Iterator iterator;
-    unsigned int i;
-
-    EINA_ARRAY_ITER_NEXT(array, i, p_mi, iterator)
-    {
-        playback_service_list_append(mpd->p_ps, p_mi);
-    }
-
+    playback_service_list_replace_all(mpd->p_ps, (media_item **)array->data,
+                                      eina_array_count(array), pos);
     eina_array_free(array);
 
-    playback_service_list_set_pos(mpd->p_ps, pos);
     playback_service_start(mpd->p_ps, 0);
 
     update_player_display(mpd);
@@ -39,6 +39,7 @@
 #include "audio_player.h"
 #include "playback_service.h"
 #include "utils.h"
+#include "thumbnailer.h"
 #include "preferences/preferences.h"
 
 #include "views/audio_view.h"
@@ -75,6 +76,9 @@ struct interface {
     /* Miniplayer */
     audio_player *p_mini_player;
     Evas_Object *mini_player_layout;
+
+    /* List icons */
+    thumbnailer *p_thumbnailer;
 };
 
 struct
@@ -145,6 +149,12 @@ intf_get_window(interface *intf)
     return intf->win;
 }
 
+thumbnailer *
+intf_get_thumbnailer(interface *intf)
+{
+    return intf->p_thumbnailer;
+}
+
 /* CREATION */
 static Evas_Object *
 create_button(Evas_Object *parent, const char *style)
@@ -541,6 +551,8 @@ intf_create(application *app)
     intf->win = elm_win_util_standard_add(PACKAGE, PACKAGE);
     elm_win_autodel_set(intf->win, EINA_TRUE);
 
+    intf->p_thumbnailer = thumbnailer_create(intf->win);
+
     /* Change colors */
 
     // 2.3.1
@@ -607,6 +619,10 @@ intf_create(application *app)
 
     ps_register_on_emotion_restart_cb(application_get_playback_service(intf->p_app), intf_on_emotion_restart_cb, intf);
 
+    /* Offer to resume the queue of the previous run */
+    if (playback_service_list_get_item(application_get_playback_service(intf->p_app)) != NULL)
+        intf_mini_player_visible_set(intf, true);
+
     media_library* p_ml = (media_library*)application_get_media_library(intf->p_app);
     media_library_register_progress_cb( p_ml, &intf_scan_progress_set_cb, intf );
 
@@ -638,6 +654,9 @@ intf_destroy(interface *intf)
     if(intf->p_mini_player != NULL)
         destroy_audio_player(intf->p_mini_player);
 
+    if(intf->p_thumbnailer != NULL)
+        thumbnailer_destroy(intf->p_thumbnailer);
+
     /* The window is the parent of all the objects:
     win, layout, main_box, nf_content, sidebar, sidebar_toggle_btn,
     popup, popup_toggle_btn, mini_player_layout, no need to free them */
@@ -115,6 +115,11 @@ intf_get_main_naviframe(interface *intf);
 Evas_Object *
 intf_get_window(interface *intf);
 
+typedef struct thumbnailer thumbnailer;
+
+thumbnailer *
+intf_get_thumbnailer(interface *intf);
+
 /* Media Library */
 void
 intf_register_file_changed(interface *intf, view_e type,
@@ -135,9 +140,12 @@ typedef struct list_view
     list_sys* p_sys;
     void            (*pf_del)(list_sys* p_sys);
     list_view_item* (*pf_append_item)(list_sys* p_sys, void* p_item);
+    /* Inserts the item before p_before, or appends it if p_before is NULL */
+    list_view_item* (*pf_insert_item)(list_sys* p_sys, void* p_item, list_view_item* p_before);
     void            (*pf_clear)(list_sys* p_sys);
     const void*     (*pf_get_item)(list_view_item* p_list_item);
     void            (*pf_set_item)(list_view_item* p_list_item, void* p_item);
+    void            (*pf_remove_item)(list_sys* p_sys, list_view_item* p_list_item);
     Evas_Object*    (*pf_get_widget)(list_sys* p_sys);
 } list_view;
 
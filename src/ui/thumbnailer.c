@@ -0,0 +1,315 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#include "common.h"
+
+#include <Elementary.h>
+
+#include "thumbnailer.h"
+#include "utils.h"
+#include "media/artwork.h"
+
+/*
+ * Images are decoded by the Evas preload thread, at icon size: the JPEG loader
+ * downscales while decoding, so the full size image is never decoded.
+ * A hidden loader object is preloaded for each image. It then stays alive to
+ * keep the decoded image in the Evas image cache, where the images displayed
+ * by the rows find it instead of decoding it again.
+ *
+ * Thumbnails displayed by realized rows are always kept. Genlist deletes the
+ * row contents when it unrealizes them, their thumbnails, as well as the
+ * prefetched ones, then go to a bounded LRU list. The oldest unused thumbnails
+ * are released, so memory doesn't grow with the size of the library.
+ */
+
+/* Number of decoded thumbnails kept while no row displays them */
+#define THUMBNAILER_MAX_UNUSED 64
+
+typedef struct thumbnail thumbnail;
+
+/* A row displaying, or waiting for, a thumbnail */
+typedef struct thumbnail_user
+{
+    thumbnail*          p_thumbnail;
+    Evas_Object*        p_layout;
+    const char*         psz_part;       /* Interned */
+    bool                b_waiting;
+} thumbnail_user;
+
+struct thumbnail
+{
+    thumbnailer*        p_thumbnailer;
+    const char*         psz_path;       /* Interned, key of p_thumbnails */
+    Evas_Object*        p_loader;
+    bool                b_ready;
+    bool                b_failed;
+    Eina_List*          p_users;
+    Eina_List*          p_unused_node;  /* Node in p_unused, if not used */
+};
+
+struct thumbnailer
+{
+    Evas*               p_evas;
+    /* All the thumbnails, being decoded or decoded, by path */
+    Eina_Hash*          p_thumbnails;
+    /* Thumbnails no row uses, least recently used first */
+    Eina_List*          p_unused;
+    unsigned int        i_nb_unused;
+};
+
+static Evas_Object*
+thumbnail_image_add(Evas_Object *p_parent, const char *psz_path)
+{
+    Evas_Object *p_img = elm_icon_add(p_parent);
+    /* Same load size as the loader, so that the cached image is used */
+    elm_image_prescale_set(p_img, THUMBNAILER_ICON_SIZE);
+    elm_image_file_set(p_img, psz_path, NULL);
+
+    elm_image_resizable_set(p_img, EINA_TRUE, EINA_TRUE);
+    evas_object_size_hint_align_set(p_img, EVAS_HINT_FILL, EVAS_HINT_FILL);
+    evas_object_size_hint_weight_set(p_img, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+    return p_img;
+}
+
+static void
+thumbnail_user_layout_del_cb(void *data, Evas *e, Evas_Object *obj, void *event_info);
+
+static void
+thumbnail_destroy(thumbnail *p_thumbnail)
+{
+    thumbnailer *p_thumbnailer = p_thumbnail->p_thumbnailer;
+    thumbnail_user *p_user;
+
+    EINA_LIST_FREE(p_thumbnail->p_users, p_user)
+    {
+        evas_object_event_callback_del_full(p_user->p_layout, EVAS_CALLBACK_DEL,
+                thumbnail_user_layout_del_cb, p_user);
+        eina_stringshare_del(p_user->psz_part);
+        free(p_user);
+    }
+
+    if (p_thumbnail->p_unused_node != NULL)
+    {
+        p_thumbnailer->p_unused = eina_list_remove_list(p_thumbnailer->p_unused, p_thumbnail->p_unused_node);
+        p_thumbnailer->i_nb_unused--;
+    }
+    /* Also cancels the preload if it's still running */
+    evas_object_del(p_thumbnail->p_loader);
+    eina_hash_del_by_key(p_thumbnailer->p_thumbnails, p_thumbnail->psz_path);
+    eina_stringshare_del(p_thumbnail->psz_path);
+    free(p_thumbnail);
+}
+
+/* Moves a thumbnail to the most recently used end of the unused list, and
+ * releases the least recently used ones if there are too many */
+static void
+thumbnail_set_unused(thumbnail *p_thumbnail)
+{
+    thumbnailer *p_thumbnailer = p_thumbnail->p_thumbnailer;
+
+    if (p_thumbnail->p_unused_node != NULL)
+    {
+        p_thumbnailer->p_unused = eina_list_demote_list(p_thumbnailer->p_unused, p_thumbnail->p_unused_node);
+        return;
+    }
+    p_thumbnailer->p_unused = eina_list_append(p_thumbnailer->p_unused, p_thumbnail);
+    p_thumbnail->p_unused_node = eina_list_last(p_thumbnailer->p_unused);
+    p_thumbnailer->i_nb_unused++;
+
+    while (p_thumbnailer->i_nb_unused > THUMBNAILER_MAX_UNUSED)
+        thumbnail_destroy(eina_list_data_get(p_thumbnailer->p_unused));
+}
+
+static void
+thumbnail_set_used(thumbnail *p_thumbnail)
+{
+    thumbnailer *p_thumbnailer = p_thumbnail->p_thumbnailer;
+
+    if (p_thumbnail->p_unused_node == NULL)
+        return;
+    p_thumbnailer->p_unused = eina_list_remove_list(p_thumbnailer->p_unused, p_thumbnail->p_unused_node);
+    p_thumbnail->p_unused_node = NULL;
+    p_thumbnailer->i_nb_unused--;
+}
+
+static void
+thumbnail_user_layout_del_cb(void *data, Evas *e, Evas_Object *obj, void *event_info)
+{
+    thumbnail_user *p_user = data;
+    thumbnail *p_thumbnail = p_user->p_thumbnail;
+
+    p_thumbnail->p_users = eina_list_remove(p_thumbnail->p_users, p_user);
+    eina_stringshare_del(p_user->psz_part);
+    free(p_user);
+
+    if (p_thumbnail->p_users != NULL)
+        return;
+    if (p_thumbnail->b_failed)
+        thumbnail_destroy(p_thumbnail);
+    else
+        thumbnail_set_unused(p_thumbnail);
+}
+
+static void
+thumbnail_loader_preloaded_cb(void *data, Evas *e, Evas_Object *obj, void *event_info)
+{
+    thumbnail *p_thumbnail = data;
+    Eina_List *it;
+    thumbnail_user *p_user;
+
+    /* Failed images keep their placeholder */
+    if (evas_object_image_load_error_get(obj) != EVAS_LOAD_ERROR_NONE)
+        p_thumbnail->b_failed = true;
+    else
+        p_thumbnail->b_ready = true;
+
+    EINA_LIST_FOREACH(p_thumbnail->p_users, it, p_user)
+    {
+        if (p_user->b_waiting && p_thumbnail->b_ready)
+            elm_layout_content_set(p_user->p_layout, p_user->psz_part,
+                    thumbnail_image_add(p_user->p_layout, p_thumbnail->psz_path));
+        p_user->b_waiting = false;
+    }
+    if (p_thumbnail->b_failed && p_thumbnail->p_users == NULL)
+        thumbnail_destroy(p_thumbnail);
+}
+
+/* Returns the thumbnail of psz_path, and starts decoding it if needed */
+static thumbnail*
+thumbnailer_get(thumbnailer *p_thumbnailer, const char *psz_path)
+{
+    const char *psz_key = eina_stringshare_add(psz_path);
+    thumbnail *p_thumbnail = eina_hash_find(p_thumbnailer->p_thumbnails, psz_key);
+    if (p_thumbnail != NULL)
+    {
+        eina_stringshare_del(psz_key);
+        return p_thumbnail;
+    }
+
+    p_thumbnail = calloc(1, sizeof(*p_thumbnail));
+    if (p_thumbnail == NULL)
+    {
+        eina_stringshare_del(psz_key);
+        return NULL;
+    }
+    p_thumbnail->p_thumbnailer = p_thumbnailer;
+    p_thumbnail->psz_path = psz_key;
+
+    /* Only the header is read here, the pixels are decoded by the preload */
+    p_thumbnail->p_loader = evas_object_image_add(p_thumbnailer->p_evas);
+    evas_object_image_load_size_set(p_thumbnail->p_loader, THUMBNAILER_ICON_SIZE, THUMBNAILER_ICON_SIZE);
+    evas_object_image_file_set(p_thumbnail->p_loader, psz_path, NULL);
+    if (evas_object_image_load_error_get(p_thumbnail->p_loader) != EVAS_LOAD_ERROR_NONE ||
+            eina_hash_add(p_thumbnailer->p_thumbnails, p_thumbnail->psz_path, p_thumbnail) == EINA_FALSE)
+    {
+        LOGW("Can't load thumbnail %s", psz_path);
+        evas_object_del(p_thumbnail->p_loader);
+        eina_stringshare_del(p_thumbnail->psz_path);
+        free(p_thumbnail);
+        return NULL;
+    }
+    evas_object_event_callback_add(p_thumbnail->p_loader, EVAS_CALLBACK_IMAGE_PRELOADED,
+            thumbnail_loader_preloaded_cb, p_thumbnail);
+    evas_object_image_preload(p_thumbnail->p_loader, EINA_FALSE);
+    return p_thumbnail;
+}
+
+void
+thumbnailer_content_set(thumbnailer *p_thumbnailer, Evas_Object *p_layout, const char *psz_part,
+        const char *psz_path, const char *psz_placeholder)
+{
+    thumbnail *p_thumbnail = NULL;
+
+    if (psz_path != NULL)
+        p_thumbnail = thumbnailer_get(p_thumbnailer, psz_path);
+    if (p_thumbnail == NULL || p_thumbnail->b_failed)
+    {
+        elm_layout_content_set(p_layout, psz_part, create_icon(p_layout, psz_placeholder));
+        return;
+    }
+
+    thumbnail_user *p_user = malloc(sizeof(*p_user));
+    if (p_user == NULL)
+        return;
+    p_user->p_thumbnail = p_thumbnail;
+    p_user->p_layout = p_layout;
+    p_user->psz_part = eina_stringshare_add(psz_part);
+    p_user->b_waiting = !p_thumbnail->b_ready;
+    p_thumbnail->p_users = eina_list_append(p_thumbnail->p_users, p_user);
+    thumbnail_set_used(p_thumbnail);
+    artwork_mark_used(psz_path);
+
+    if (p_thumbnail->b_ready)
+        elm_layout_content_set(p_layout, psz_part, thumbnail_image_add(p_layout, psz_path));
+    else
+        elm_layout_content_set(p_layout, psz_part, create_icon(p_layout, psz_placeholder));
+    /* Genlist deletes the layout when the row is unrealized */
+    evas_object_event_callback_add(p_layout, EVAS_CALLBACK_DEL, thumbnail_user_layout_del_cb, p_user);
+}
+
+void
+thumbnailer_prefetch(thumbnailer *p_thumbnailer, const char *psz_path)
+{
+    thumbnail *p_thumbnail = thumbnailer_get(p_thumbnailer, psz_path);
+    if (p_thumbnail != NULL && p_thumbnail->p_users == NULL)
+        thumbnail_set_unused(p_thumbnail);
+}
+
+thumbnailer*
+thumbnailer_create(Evas_Object *p_win)
+{
+    thumbnailer *p_thumbnailer = calloc(1, sizeof(*p_thumbnailer));
+    if (p_thumbnailer == NULL)
+        return NULL;
+    p_thumbnailer->p_evas = evas_object_evas_get(p_win);
+    p_thumbnailer->p_thumbnails = eina_hash_stringshared_new(NULL);
+    if (p_thumbnailer->p_thumbnails == NULL)
+    {
+        free(p_thumbnailer);
+        return NULL;
+    }
+    return p_thumbnailer;
+}
+
+static Eina_Bool
+thumbnailer_collect_cb(const Eina_Hash *hash, const void *key, void *data, void *fdata)
+{
+    Eina_List **pp_thumbnails = fdata;
+    *pp_thumbnails = eina_list_append(*pp_thumbnails, data);
+    return EINA_TRUE;
+}
+
+void
+thumbnailer_destroy(thumbnailer *p_thumbnailer)
+{
+    Eina_List *p_thumbnails = NULL;
+    thumbnail *p_thumbnail;
+
+    /* Thumbnails remove themselves from the hash, it can't be walked meanwhile */
+    eina_hash_foreach(p_thumbnailer->p_thumbnails, thumbnailer_collect_cb, &p_thumbnails);
+    EINA_LIST_FREE(p_thumbnails, p_thumbnail)
+        thumbnail_destroy(p_thumbnail);
+    eina_hash_free(p_thumbnailer->p_thumbnails);
+    free(p_thumbnailer);
+}
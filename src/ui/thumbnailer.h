@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * Copyright © 2015-2016 VideoLAN, VideoLabs SAS
+ *****************************************************************************
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+/*
+ * By committing to this project, you allow VideoLAN and VideoLabs to relicense
+ * the code to a different OSI approved license, in case it is required for
+ * compatibility with the Store
+ *****************************************************************************/
+
+#ifndef THUMBNAILER_H_
+#define THUMBNAILER_H_
+
+#include <Elementary.h>
+
+/* Size in pixels the list icons are decoded at */
+#define THUMBNAILER_ICON_SIZE 96
+
+typedef struct thumbnailer thumbnailer;
+
+thumbnailer*
+thumbnailer_create(Evas_Object *p_win);
+
+void
+thumbnailer_destroy(thumbnailer *p_thumbnailer);
+
+/*
+ * Sets an icon sized image of psz_path as the psz_part content of p_layout.
+ * The image is decoded in the background, the psz_placeholder icon is
+ * displayed until then, or if the image can't be decoded.
+ * Concurrent requests for the same image share a single decode.
+ */
+void
+thumbnailer_content_set(thumbnailer *p_thumbnailer, Evas_Object *p_layout, const char *psz_part,
+        const char *psz_path, const char *psz_placeholder);
+
+/*
+ * Starts decoding the thumbnail of psz_path, for a row that is about to be
+ * displayed. Until a row displays it, it counts as an unused thumbnail.
+ */
+void
+thumbnailer_prefetch(thumbnailer *p_thumbnailer, const char *psz_path);
+
+#endif /* THUMBNAILER_H_ */
@@ -29,6 +29,7 @@
 #include "media/album_item.h"
 #include "controller/media_controller.h"
 #include "ui/utils.h"
+#include "ui/thumbnailer.h"
 
 struct list_sys
 {
@@ -42,6 +43,7 @@ struct list_view_item
     const Elm_Genlist_Item_Class*   itc;
     album_item*                     p_album_item;
     Elm_Object_Item*                p_object_item;
+    list_view_labels                labels;
 };
 
 /* List songs when an album is clicked */
@@ -63,6 +65,7 @@ free_list_item_data(void *data, Evas_Object *obj, void *event_info)
 {
     list_view_item *p_view_item = data;
     album_item_destroy(p_view_item->p_album_item);
+    list_view_labels_clear(&p_view_item->labels);
     free(p_view_item);
 }
 
@@ -79,46 +82,50 @@ genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
         if (part && !strcmp(part, "elm.icon.1")) {
             layout = elm_layout_add(obj);
             elm_layout_theme_set(layout, "layout", "list/B/type.1", "default");
-            Evas_Object *icon;
-            if (ali->p_album_item->psz_artwork != NULL)
-                icon = create_image(layout, ali->p_album_item->psz_artwork);
-            else
-                icon = create_icon(layout, "background_cone.png");
-            elm_layout_content_set(layout, "elm.swallow.content", icon);
+            thumbnailer_content_set(intf_get_thumbnailer(ali->p_list_sys->p_intf), layout, "elm.swallow.content",
+                    ali->p_album_item->psz_artwork, "background_cone.png");
         }
     }
 
     return layout;
 }
 
+static void
+audio_list_album_item_update_labels(list_view_item* p_view_item)
+{
+    const album_item* p_album_item = p_view_item->p_album_item;
+    list_view_labels* p_labels = &p_view_item->labels;
+    int i_res;
+
+    list_view_labels_clear(p_labels);
+    const char* name = p_album_item->psz_name;
+    if (*name == 0)
+        name = "Unknown Album";
+    if (asprintf(&p_labels->psz_main, "<b>%s</b>", name) < 0)
+        p_labels->psz_main = NULL;
+
+    if (p_album_item->i_duration > 0) {
+        char* psz_duration = media_timetostr(p_album_item->i_duration / 1000);
+        i_res = asprintf(&p_labels->psz_sub_right, "%d track%s - %s", p_album_item->i_nb_tracks,
+                p_album_item->i_nb_tracks > 1 ? "s" : "", psz_duration);
+        free(psz_duration);
+    }
+    else
+        i_res = asprintf(&p_labels->psz_sub_right, "%d track%s", p_album_item->i_nb_tracks,
+                p_album_item->i_nb_tracks > 1 ? "s" : "" );
+    if (i_res < 0)
+        p_labels->psz_sub_right = NULL;
+
+    if (p_album_item->i_release_date &&
+            asprintf(&p_labels->psz_sub_left, "%lld", (long long)p_album_item->i_release_date) < 0)
+        p_labels->psz_sub_left = NULL;
+}
+
 static char *
 genlist_text_get_cb(void *data, Evas_Object *obj, const char *part)
 {
     list_view_item *p_view_item = data;
-    const Elm_Genlist_Item_Class *itc = p_view_item->itc;
-    char *buf = NULL;
-
-    if (itc->item_style && !strcmp(itc->item_style, "2line.top.3")) {
-        if (part && !strcmp(part, "elm.text.main.left.top")) {
-            const char* name = p_view_item->p_album_item->psz_name;
-            if (*name == 0)
-                name = "Unknown Album";
-            asprintf(&buf, "<b>%s</b>", name);
-            return buf;
-        }
-        else if (!strcmp(part, "elm.text.sub.right.bottom")) {
-            asprintf(&buf, "%d track%s", p_view_item->p_album_item->i_nb_tracks,
-                    p_view_item->p_album_item->i_nb_tracks > 1 ? "s" : "" );
-            return buf;
-        }
-        else if (!strcmp(part, "elm.text.sub.left.bottom")) {
-            if (p_view_item->p_album_item->i_release_date) {
-                asprintf(&buf, "%lld", (long long)p_view_item->p_album_item->i_release_date);
-                return buf;
-            }
-        }
-    }
-    return NULL;
+    return list_view_labels_get(&p_view_item->labels, part);
 }
 
 static const void*
@@ -131,12 +138,20 @@ static void
 audio_list_album_item_set_media_item(list_view_item* p_view_item, void* p_data)
 {
     album_item* p_media_item = (album_item*)p_data;
+    album_item_destroy(p_view_item->p_album_item);
     p_view_item->p_album_item = p_media_item;
+    audio_list_album_item_update_labels(p_view_item);
     ecore_main_loop_thread_safe_call_async((Ecore_Cb)elm_genlist_item_update, p_view_item->p_object_item);
 }
 
+static void
+audio_list_album_item_remove(list_sys* p_list_sys, list_view_item* p_item)
+{
+    list_view_remove_object_item(p_list_sys, p_item->p_object_item);
+}
+
 static list_view_item*
-audio_list_album_view_append_item(list_sys *p_list_sys, void* p_data)
+audio_list_album_view_insert_item(list_sys *p_list_sys, void* p_data, list_view_item* p_before)
 {
     album_item* p_album_item = (album_item*)p_data;
     list_view_item *p_view_item = calloc(1, sizeof(*p_view_item));
@@ -144,38 +159,46 @@ audio_list_album_view_append_item(list_sys *p_list_sys, void* p_data)
     p_view_item->itc = p_list_sys->p_default_item_class;
 
     p_view_item->p_album_item = p_album_item;
+    audio_list_album_item_update_labels(p_view_item);
 
-    /* Set and append new item in the genlist */
-    Elm_Object_Item *it = elm_genlist_item_append(p_list_sys->p_list,
+    /* Set and insert the new item in the genlist */
+    Elm_Object_Item *it = list_view_insert_object_item(p_list_sys,
             p_list_sys->p_default_item_class,           /* genlist item class               */
             p_view_item,                                /* genlist item class user data     */
-            NULL,                                       /* genlist parent item              */
-            ELM_GENLIST_ITEM_NONE,                      /* genlist item type                */
+            p_before != NULL ? p_before->p_object_item : NULL,
             audio_list_album_item_selected,             /* genlist select smart callback    */
             p_view_item);                               /* genlist smart callback user data */
 
     /* */
+    p_view_item->p_object_item = it;
     elm_object_item_del_cb_set(it, free_list_item_data);
     list_view_toggle_empty(p_list_sys, false);
     return p_view_item;
 }
 
+static list_view_item*
+audio_list_album_view_append_item(list_sys *p_list_sys, void* p_data)
+{
+    return audio_list_album_view_insert_item(p_list_sys, p_data, NULL);
+}
+
 static void
 audio_list_album_view_delete(list_sys* p_list_sys)
 {
     media_library_controller_destroy(p_list_sys->p_ctrl);
+    list_view_common_cleanup(p_list_sys);
     elm_genlist_item_class_free(p_list_sys->p_default_item_class);
     free(p_list_sys);
 }
 
-static void
-audio_list_album_get_albums_cb(media_library* p_ml, media_library_list_cb cb, void* p_user_data )
+static media_library_query*
+audio_list_album_get_albums_cb(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data )
 {
     list_sys* p_list_sys = (list_sys*)p_user_data;
     if (p_list_sys->i_artist_id != 0)
-        media_library_get_artist_albums(p_ml, p_list_sys->i_artist_id, cb, p_list_sys->p_ctrl);
+        return media_library_get_artist_albums(p_ml, p_list_sys->i_artist_id, p_sort, i_priority, cb, p_list_sys->p_ctrl);
     else
-        media_library_get_albums(p_ml, cb, p_list_sys->p_ctrl);
+        return media_library_get_albums(p_ml, p_sort, i_priority, cb, p_list_sys->p_ctrl);
 }
 
 list_view*
@@ -199,13 +222,20 @@ audio_list_album_view_create(interface* p_intf, Evas_Object* p_parent, unsigned
     p_list_sys->p_default_item_class->func.content_get = genlist_content_get_cb;
 
     p_list_view->pf_append_item = &audio_list_album_view_append_item;
+    p_list_view->pf_insert_item = &audio_list_album_view_insert_item;
     p_list_view->pf_get_item = &audio_list_album_item_get_media_item;
     p_list_view->pf_set_item = &audio_list_album_item_set_media_item;
+    p_list_view->pf_remove_item = &audio_list_album_item_remove;
     p_list_view->pf_del = &audio_list_album_view_delete;
 
     application* p_app = intf_get_application( p_intf );
     p_list_sys->p_ctrl = album_controller_create(p_app, p_list_view);
     media_library_controller_set_content_callback(p_list_sys->p_ctrl, audio_list_album_get_albums_cb, p_list_sys);
+    if (i_artist_id == 0)
+        media_library_controller_set_snapshot(p_list_sys->p_ctrl, "albums");
+    else
+        // The album items don't carry their artist, new albums come from the content query
+        media_library_controller_set_filter(p_list_sys->p_ctrl, NULL, NULL);
     media_library_controller_refresh(p_list_sys->p_ctrl);
     return p_list_view;
 }
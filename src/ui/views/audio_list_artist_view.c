@@ -29,6 +29,7 @@
 #include "media/artist_item.h"
 #include "controller/media_controller.h"
 #include "ui/utils.h"
+#include "ui/thumbnailer.h"
 
 struct list_sys
 {
@@ -41,6 +42,7 @@ struct list_view_item
     const Elm_Genlist_Item_Class*   itc;
     artist_item*                    p_artist_item;
     Elm_Object_Item*                p_object_item;
+    list_view_labels                labels;
 };
 
 /*
@@ -65,6 +67,7 @@ free_list_item_data(void *data, Evas_Object *obj, void *event_info)
 {
     list_view_item *p_view_item = data;
     artist_item_destroy(p_view_item->p_artist_item);
+    list_view_labels_clear(&p_view_item->labels);
     free(p_view_item);
 }
 
@@ -81,36 +84,32 @@ genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
         if (part && !strcmp(part, "elm.icon.1")) {
             layout = elm_layout_add(obj);
             elm_layout_theme_set(layout, "layout", "list/B/type.1", "default");
-            Evas_Object *icon;
-            if (ali->p_artist_item->psz_artwork != NULL)
-                icon = create_image(layout, ali->p_artist_item->psz_artwork);
-            else
-                icon = create_icon(layout, "background_cone.png");
-            elm_layout_content_set(layout, "elm.swallow.content", icon);
+            thumbnailer_content_set(intf_get_thumbnailer(ali->p_list_sys->p_intf), layout, "elm.swallow.content",
+                    ali->p_artist_item->psz_artwork, "background_cone.png");
         }
     }
 
     return layout;
 }
 
+static void
+audio_list_artist_item_update_labels(list_view_item* p_view_item)
+{
+    list_view_labels* p_labels = &p_view_item->labels;
+
+    list_view_labels_clear(p_labels);
+    if (asprintf(&p_labels->psz_main, "<b>%s</b>", artist_item_get_name(p_view_item->p_artist_item)) < 0)
+        p_labels->psz_main = NULL;
+    if (asprintf(&p_labels->psz_sub_right, "%d album%s", p_view_item->p_artist_item->i_nb_albums,
+            p_view_item->p_artist_item->i_nb_albums > 1 ? "s" : "" ) < 0)
+        p_labels->psz_sub_right = NULL;
+}
+
 static char *
 genlist_text_get_cb(void *data, Evas_Object *obj, const char *part)
 {
     list_view_item *p_view_item = data;
-    const Elm_Genlist_Item_Class *itc = p_view_item->itc;
-    char *buf;
-
-    if (itc->item_style && !strcmp(itc->item_style, "2line.top.3")) {
-        if (part && !strcmp(part, "elm.text.main.left.top")) {
-            asprintf(&buf, "<b>%s</b>", artist_item_get_name(p_view_item->p_artist_item));
-            return buf;
-        } else if (!strcmp(part, "elm.text.sub.right.bottom")) {
-            asprintf(&buf, "%d album%s", p_view_item->p_artist_item->i_nb_albums,
-                    p_view_item->p_artist_item->i_nb_albums > 1 ? "s" : "" );
-            return buf;
-        }
-    }
-    return NULL;
+    return list_view_labels_get(&p_view_item->labels, part);
 }
 
 static const void*
@@ -123,12 +122,20 @@ static void
 audio_list_artist_item_set_media_item(list_view_item* p_view_item, void* p_data)
 {
     artist_item* p_media_item = (artist_item*)p_data;
+    artist_item_destroy(p_view_item->p_artist_item);
     p_view_item->p_artist_item = p_media_item;
+    audio_list_artist_item_update_labels(p_view_item);
     ecore_main_loop_thread_safe_call_async((Ecore_Cb)elm_genlist_item_update, p_view_item->p_object_item);
 }
 
+static void
+audio_list_artist_item_remove(list_sys* p_list_sys, list_view_item* p_item)
+{
+    list_view_remove_object_item(p_list_sys, p_item->p_object_item);
+}
+
 static list_view_item*
-audio_list_artist_view_append_item(list_sys *p_sys, void* p_data)
+audio_list_artist_view_insert_item(list_sys *p_sys, void* p_data, list_view_item* p_before)
 {
     artist_item* p_artist_item = (artist_item*)p_data;
     list_view_item *p_view_item = calloc(1, sizeof(*p_view_item));
@@ -136,22 +143,29 @@ audio_list_artist_view_append_item(list_sys *p_sys, void* p_data)
     p_view_item->itc = p_sys->p_default_item_class;
 
     p_view_item->p_artist_item = p_artist_item;
+    audio_list_artist_item_update_labels(p_view_item);
 
-    /* Set and append new item in the genlist */
-    Elm_Object_Item *it = elm_genlist_item_append(p_sys->p_list,
+    /* Set and insert the new item in the genlist */
+    Elm_Object_Item *it = list_view_insert_object_item(p_sys,
             p_sys->p_default_item_class,                /* genlist item class               */
             p_view_item,                                /* genlist item class user data     */
-            NULL,                                       /* genlist parent item              */
-            ELM_GENLIST_ITEM_NONE,                      /* genlist item type                */
+            p_before != NULL ? p_before->p_object_item : NULL,
             audio_list_artist_item_selected,            /* genlist select smart callback    */
             p_view_item);                               /* genlist smart callback user data */
 
     /* */
+    p_view_item->p_object_item = it;
     elm_object_item_del_cb_set(it, free_list_item_data);
     list_view_toggle_empty(p_sys, false);
     return p_view_item;
 }
 
+static list_view_item*
+audio_list_artist_view_append_item(list_sys *p_sys, void* p_data)
+{
+    return audio_list_artist_view_insert_item(p_sys, p_data, NULL);
+}
+
 list_view*
 audio_list_artist_view_create(interface* p_intf, Evas_Object* p_parent, list_view_create_option opts)
 {
@@ -172,11 +186,14 @@ audio_list_artist_view_create(interface* p_intf, Evas_Object* p_parent, list_vie
     p_list_sys->p_default_item_class->func.content_get = genlist_content_get_cb;
 
     p_list_view->pf_append_item = &audio_list_artist_view_append_item;
+    p_list_view->pf_insert_item = &audio_list_artist_view_insert_item;
     p_list_view->pf_get_item = &audio_list_artist_item_get_media_item;
     p_list_view->pf_set_item = &audio_list_artist_item_set_media_item;
+    p_list_view->pf_remove_item = &audio_list_artist_item_remove;
 
     application* p_app = intf_get_application( p_intf );
     p_list_sys->p_ctrl = artist_controller_create(p_app, p_list_view);
+    media_library_controller_set_snapshot( p_list_sys->p_ctrl, "artists" );
     media_library_controller_refresh( p_list_sys->p_ctrl );
 
     return p_list_view;
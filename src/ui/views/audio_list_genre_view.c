@@ -45,6 +45,7 @@ struct list_view_item
     const Elm_Genlist_Item_Class*   itc;
     genre_item*                     p_genre_item;
     Elm_Object_Item*                p_object_item;
+    list_view_labels                labels;
 };
 
 static void
@@ -52,26 +53,26 @@ free_list_item_data(void *data, Evas_Object *obj, void *event_info)
 {
     list_view_item *ali = data;
     genre_item_destroy(ali->p_genre_item);
+    list_view_labels_clear(&ali->labels);
     free(ali);
 }
 
+static void
+audio_list_genres_item_update_labels(list_view_item *ali)
+{
+    list_view_labels_clear(&ali->labels);
+    if (asprintf(&ali->labels.psz_main, "<b>%s</b>", ali->p_genre_item->psz_name) < 0)
+        ali->labels.psz_main = NULL;
+    if (asprintf(&ali->labels.psz_sub_right, "%d track%s", ali->p_genre_item->i_nb_tracks,
+            ali->p_genre_item->i_nb_tracks > 1 ? "s" : "" ) < 0)
+        ali->labels.psz_sub_right = NULL;
+}
+
 static char *
 genlist_text_get_cb(void *data, Evas_Object *obj, const char *part)
 {
     list_view_item *ali = data;
-    const Elm_Genlist_Item_Class *itc = ali->itc;
-    char *buf;
-
-    /* Check the item class style and put the current folder or file name as a string */
-    /* Then put this string as the genlist item label */
-    if (itc->item_style && !strcmp(itc->item_style, "2line.top.3")) {
-        if (part && !strcmp(part, "elm.text.main.left.top")) {
-            // Don't display track number out of the album songs view (ie. when i_album_id != 0)
-            asprintf(&buf, "<b>%s</b>", ali->p_genre_item->psz_name);
-            return buf;
-        }
-    }
-    return NULL;
+    return list_view_labels_get(&ali->labels, part);
 }
 
 static const void*
@@ -84,10 +85,18 @@ static void
 audio_list_genres_item_set_genre_item(list_view_item* p_item, void* p_data)
 {
     genre_item *p_genre_item = (genre_item*)p_data;
+    genre_item_destroy(p_item->p_genre_item);
     p_item->p_genre_item = p_genre_item;
+    audio_list_genres_item_update_labels(p_item);
     ecore_main_loop_thread_safe_call_async((Ecore_Cb)elm_genlist_item_update, p_item->p_object_item);
 }
 
+static void
+audio_list_genres_item_remove(list_sys* p_list_sys, list_view_item* p_item)
+{
+    list_view_remove_object_item(p_list_sys, p_item->p_object_item);
+}
+
 static Evas_Object*
 genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
 {
@@ -126,7 +135,7 @@ audio_list_genres_item_selected(void *data, Evas_Object *obj, void *event_info)
 
 
 static list_view_item*
-audio_list_genres_view_append_item(list_sys *p_sys, void* p_data)
+audio_list_genres_view_insert_item(list_sys *p_sys, void* p_data, list_view_item* p_before)
 {
     genre_item* p_genre_item = (genre_item*)p_data;
     list_view_item *ali = calloc(1, sizeof(*ali));
@@ -134,26 +143,34 @@ audio_list_genres_view_append_item(list_sys *p_sys, void* p_data)
     ali->itc = p_sys->p_default_item_class;
 
     ali->p_genre_item = p_genre_item;
+    audio_list_genres_item_update_labels(ali);
 
-    /* Set and append new item in the genlist */
-    Elm_Object_Item *it = elm_genlist_item_append(p_sys->p_list,
+    /* Set and insert the new item in the genlist */
+    Elm_Object_Item *it = list_view_insert_object_item(p_sys,
             p_sys->p_default_item_class,                /* genlist item class               */
             ali,                                        /* genlist item class user data     */
-            NULL,                                       /* genlist parent item              */
-            ELM_GENLIST_ITEM_NONE,                      /* genlist item type                */
+            p_before != NULL ? p_before->p_object_item : NULL,
             audio_list_genres_item_selected,            /* genlist select smart callback    */
             ali);                                       /* genlist smart callback user data */
 
     /* */
+    ali->p_object_item = it;
     elm_object_item_del_cb_set(it, free_list_item_data);
     list_view_toggle_empty(p_sys, false);
     return ali;
 }
 
+static list_view_item*
+audio_list_genres_view_append_item(list_sys *p_sys, void* p_data)
+{
+    return audio_list_genres_view_insert_item(p_sys, p_data, NULL);
+}
+
 static void
 audio_list_genres_view_delete(list_sys* p_list_sys)
 {
     media_library_controller_destroy(p_list_sys->p_ctrl);
+    list_view_common_cleanup(p_list_sys);
     elm_genlist_item_class_free(p_list_sys->p_default_item_class);
     free(p_list_sys);
 }
@@ -179,12 +196,15 @@ audio_list_genres_view_create(interface* p_intf, Evas_Object* p_parent, list_vie
     evas_object_size_hint_align_set(p_sys->p_list, EVAS_HINT_FILL, EVAS_HINT_FILL);
 
     p_view->pf_append_item = &audio_list_genres_view_append_item;
+    p_view->pf_insert_item = &audio_list_genres_view_insert_item;
     p_view->pf_get_item = &audio_list_genres_item_get_genre_item;
     p_view->pf_set_item = &audio_list_genres_item_set_genre_item;
+    p_view->pf_remove_item = &audio_list_genres_item_remove;
     p_view->pf_del = &audio_list_genres_view_delete;
 
     application* p_app = intf_get_application( p_intf );
     p_sys->p_ctrl = genre_controller_create(p_app, p_view);
+    media_library_controller_set_snapshot(p_sys->p_ctrl, "genres");
     media_library_controller_refresh(p_view->p_sys->p_ctrl);
 
     return p_view;
@@ -32,6 +32,7 @@
 #include "list_view_private.h"
 #include "ui/interface.h"
 #include "ui/utils.h"
+#include "ui/thumbnailer.h"
 
 struct list_sys
 {
@@ -47,6 +48,7 @@ struct list_view_item
     const Elm_Genlist_Item_Class*   itc;
     media_item*                     p_media_item;
     Elm_Object_Item*                p_object_item;
+    list_view_labels                labels;
 };
 
 static void
@@ -54,38 +56,37 @@ free_list_item_data(void *data, Evas_Object *obj, void *event_info)
 {
     list_view_item *ali = data;
     media_item_destroy(ali->p_media_item);
+    list_view_labels_clear(&ali->labels);
     free(ali);
 }
 
+static void
+audio_list_song_item_update_labels(list_view_item *ali)
+{
+    const media_item *p_mi = ali->p_media_item;
+    int i_res;
+
+    list_view_labels_clear(&ali->labels);
+    // Don't display track number out of the album songs view (ie. when i_album_id != 0)
+    if (p_mi->i_track_number > 0 && ali->p_list->i_album_id != 0)
+        i_res = asprintf(&ali->labels.psz_main, "%d - <b>%s</b>", p_mi->i_track_number, media_item_title(p_mi));
+    else
+        i_res = asprintf(&ali->labels.psz_main, "<b>%s</b>", media_item_title(p_mi));
+    if (i_res < 0)
+        ali->labels.psz_main = NULL;
+
+    const char* psz_artist = media_item_artist(p_mi);
+    if (psz_artist == NULL)
+        psz_artist = "Unknown Artist";
+    ali->labels.psz_sub_left = strdup(psz_artist);
+    ali->labels.psz_sub_right = media_timetostr(p_mi->i_duration / 1000);
+}
+
 static char *
 genlist_text_get_cb(void *data, Evas_Object *obj, const char *part)
 {
     list_view_item *ali = data;
-    const Elm_Genlist_Item_Class *itc = ali->itc;
-    char *buf;
-
-    /* Check the item class style and put the current folder or file name as a string */
-    /* Then put this string as the genlist item label */
-    if (itc->item_style && !strcmp(itc->item_style, "2line.top.3")) {
-        if (part && !strcmp(part, "elm.text.main.left.top")) {
-            // Don't display track number out of the album songs view (ie. when i_album_id != 0)
-            if (ali->p_media_item->i_track_number > 0 && ali->p_list->i_album_id != 0)
-                asprintf(&buf, "%d - <b>%s</b>", ali->p_media_item->i_track_number, media_item_title(ali->p_media_item));
-            else
-                asprintf(&buf, "<b>%s</b>", media_item_title(ali->p_media_item));
-            return buf;
-        }
-        else if (!strcmp(part, "elm.text.sub.left.bottom")) {
-            const char* psz_artist = media_item_artist(ali->p_media_item);
-            if (psz_artist == NULL)
-                psz_artist = "Unknown Artist";
-            return strdup(psz_artist);
-        }
-        else if (!strcmp(part, "elm.text.sub.right.bottom")) {
-            return media_timetostr( ali->p_media_item->i_duration / 1000 );
-        }
-    }
-    return NULL;
+    return list_view_labels_get(&ali->labels, part);
 }
 
 static const void*
@@ -98,10 +99,18 @@ static void
 audio_list_song_item_set_media_item(list_view_item* p_item, void* p_data)
 {
     media_item *p_media_item = (media_item*)p_data;
+    media_item_destroy(p_item->p_media_item);
     p_item->p_media_item = p_media_item;
+    audio_list_song_item_update_labels(p_item);
     ecore_main_loop_thread_safe_call_async((Ecore_Cb)elm_genlist_item_update, p_item->p_object_item);
 }
 
+static void
+audio_list_song_item_remove(list_sys* p_list_sys, list_view_item* p_item)
+{
+    list_view_remove_object_item(p_list_sys, p_item->p_object_item);
+}
+
 static Evas_Object*
 genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
 {
@@ -115,12 +124,8 @@ genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
         if (part && !strcmp(part, "elm.icon.1")) {
             layout = elm_layout_add(obj);
             elm_layout_theme_set(layout, "layout", "list/B/type.1", "default");
-            Evas_Object *icon;
-            if (ali->p_media_item->psz_snapshot != NULL)
-                icon = create_image(layout, ali->p_media_item->psz_snapshot);
-            else
-                icon = create_icon(layout, "background_cone.png");
-            elm_layout_content_set(layout, "elm.swallow.content", icon);
+            thumbnailer_content_set(intf_get_thumbnailer(ali->p_list->p_intf), layout, "elm.swallow.content",
+                    ali->p_media_item->psz_snapshot, "background_cone.png");
         }
     }
 
@@ -146,7 +151,7 @@ genlist_selected_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
         if (media_item_identical(lvi->p_media_item, ali->p_media_item))
             pos = index;
 
-        eina_array_push(array, media_item_copy(lvi->p_media_item));
+        eina_array_push(array, library_item_hold((library_item*)lvi->p_media_item));
         index++;
     } while ((it = elm_genlist_item_next_get(it)) != NULL);
 
@@ -155,7 +160,7 @@ genlist_selected_cb(void *data, Evas_Object *obj EINA_UNUSED, void *event_info)
 
 
 static list_view_item*
-audio_list_song_view_append_item(list_sys *p_sys, void* p_data)
+audio_list_song_view_insert_item(list_sys *p_sys, void* p_data, list_view_item* p_before)
 {
     media_item* p_media_item = (media_item*)p_data;
     list_view_item *ali = calloc(1, sizeof(*ali));
@@ -163,49 +168,81 @@ audio_list_song_view_append_item(list_sys *p_sys, void* p_data)
     ali->itc = p_sys->p_default_item_class;
 
     ali->p_media_item = p_media_item;
+    audio_list_song_item_update_labels(ali);
 
-    /* Set and append new item in the genlist */
-    Elm_Object_Item *it = elm_genlist_item_append(p_sys->p_list,
+    /* Set and insert the new item in the genlist */
+    Elm_Object_Item *it = list_view_insert_object_item(p_sys,
             p_sys->p_default_item_class,                /* genlist item class               */
             ali,                                        /* genlist item class user data     */
-            NULL,                                       /* genlist parent item              */
-            ELM_GENLIST_ITEM_NONE,                      /* genlist item type                */
+            p_before != NULL ? p_before->p_object_item : NULL,
             genlist_selected_cb,                        /* genlist select smart callback    */
             ali);                                       /* genlist smart callback user data */
 
     /* */
+    ali->p_object_item = it;
     elm_object_item_del_cb_set(it, free_list_item_data);
     list_view_toggle_empty(p_sys, false);
     return ali;
 }
 
+static list_view_item*
+audio_list_song_view_append_item(list_sys *p_sys, void* p_data)
+{
+    return audio_list_song_view_insert_item(p_sys, p_data, NULL);
+}
+
 static void
 audio_list_song_view_delete(list_sys* p_list_sys)
 {
     media_library_controller_destroy(p_list_sys->p_ctrl);
+    list_view_common_cleanup(p_list_sys);
     elm_genlist_item_class_free(p_list_sys->p_default_item_class);
+    free(p_list_sys->psz_search_pattern);
     free(p_list_sys);
 }
 
-static void
-audio_list_song_get_artist_songs_cb(media_library* p_ml, media_library_list_cb cb, void* p_user_data)
+static media_library_query*
+audio_list_song_get_artist_songs_cb(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
 {
     list_sys* p_list_sys = (list_sys*)p_user_data;
-    media_library_get_artist_songs(p_ml, p_list_sys->i_artist_id, cb, p_list_sys->p_ctrl);
+    return media_library_get_artist_songs(p_ml, p_list_sys->i_artist_id, p_sort, i_priority, cb, p_list_sys->p_ctrl);
 }
 
-static void
-audio_list_song_get_album_songs_cb(media_library* p_ml, media_library_list_cb cb, void* p_user_data)
+static media_library_query*
+audio_list_song_get_album_songs_cb(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
 {
     list_sys* p_list_sys = (list_sys*)p_user_data;
-    media_library_get_album_songs(p_ml, p_list_sys->i_album_id, cb, p_list_sys->p_ctrl);
+    return media_library_get_album_songs(p_ml, p_list_sys->i_album_id, p_sort, i_priority, cb, p_list_sys->p_ctrl);
 }
 
-static void
-audio_list_song_get_genre_songs_cb(media_library* p_ml, media_library_list_cb cb, void* p_user_data)
+static media_library_query*
+audio_list_song_get_genre_songs_cb(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
+{
+    list_sys* p_list_sys = (list_sys*)p_user_data;
+    return media_library_get_genres_songs(p_ml, p_list_sys->i_genre_id, p_sort, i_priority, cb, p_list_sys->p_ctrl);
+}
+
+static media_library_query*
+audio_list_song_get_search_songs_cb(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
+{
+    list_sys* p_list_sys = (list_sys*)p_user_data;
+    if (p_list_sys->psz_search_pattern == NULL || *p_list_sys->psz_search_pattern == 0)
+        return NULL;
+    return media_library_search(p_ml, p_list_sys->psz_search_pattern, MEDIA_ITEM_TYPE_AUDIO, i_priority, cb, p_list_sys->p_ctrl);
+}
+
+static bool
+audio_list_song_filter_artist_songs_cb(const library_item* p_item, void* p_user_data)
 {
     list_sys* p_list_sys = (list_sys*)p_user_data;
-    media_library_get_genres_songs(p_ml, p_list_sys->i_genre_id, cb, p_list_sys->p_ctrl);
+    return ((const media_item*)p_item)->i_artist_id == p_list_sys->i_artist_id;
+}
+
+static bool
+audio_list_song_filter_album_songs_cb(const library_item* p_item, void* p_user_data)
+{
+    list_sys* p_list_sys = (list_sys*)p_user_data;
+    return ((const media_item*)p_item)->i_album_id == p_list_sys->i_album_id;
 }
 
 static list_view*
@@ -229,8 +266,10 @@ audio_list_song_view_create(interface* p_intf, Evas_Object* p_parent, list_view_
     evas_object_size_hint_align_set(p_sys->p_list, EVAS_HINT_FILL, EVAS_HINT_FILL);
 
     p_view->pf_append_item = &audio_list_song_view_append_item;
+    p_view->pf_insert_item = &audio_list_song_view_insert_item;
     p_view->pf_get_item = &audio_list_song_item_get_media_item;
     p_view->pf_set_item = &audio_list_song_item_set_media_item;
+    p_view->pf_remove_item = &audio_list_song_item_remove;
     p_view->pf_del = &audio_list_song_view_delete;
 
     application* p_app = intf_get_application( p_intf );
@@ -244,6 +283,7 @@ audio_list_song_view_all_create(interface* p_intf, Evas_Object* p_parent, list_v
 {
     list_view* p_view = audio_list_song_view_create(p_intf, p_parent, opts);
     // Default audio controller is listing all songs. No more config is required.
+    media_library_controller_set_snapshot(p_view->p_sys->p_ctrl, "songs");
     media_library_controller_refresh(p_view->p_sys->p_ctrl);
     return p_view;
 }
@@ -254,6 +294,7 @@ audio_list_song_view_artist_create(interface* p_intf, Evas_Object* p_parent, uns
     list_view* p_view = audio_list_song_view_create(p_intf, p_parent, opts);
     p_view->p_sys->i_artist_id = i_artist_id;
     media_library_controller_set_content_callback(p_view->p_sys->p_ctrl, audio_list_song_get_artist_songs_cb, p_view->p_sys);
+    media_library_controller_set_filter(p_view->p_sys->p_ctrl, audio_list_song_filter_artist_songs_cb, p_view->p_sys);
     media_library_controller_refresh(p_view->p_sys->p_ctrl);
     return p_view;
 }
@@ -263,7 +304,9 @@ audio_list_song_view_album_create(interface* p_intf, Evas_Object* p_parent, unsi
 {
     list_view* p_view = audio_list_song_view_create(p_intf, p_parent, opts);
     p_view->p_sys->i_album_id = i_album_id;
+    media_library_controller_set_sort(p_view->p_sys->p_ctrl, ML_SORT_TRACK_NUMBER, false);
     media_library_controller_set_content_callback(p_view->p_sys->p_ctrl, audio_list_song_get_album_songs_cb, p_view->p_sys);
+    media_library_controller_set_filter(p_view->p_sys->p_ctrl, audio_list_song_filter_album_songs_cb, p_view->p_sys);
     media_library_controller_refresh(p_view->p_sys->p_ctrl);
     return p_view;
 }
@@ -274,8 +317,19 @@ audio_list_song_view_genre_create(interface* p_intf, Evas_Object* p_parent, unsi
     list_view* p_view = audio_list_song_view_create(p_intf, p_parent, opts);
     p_view->p_sys->i_genre_id = i_genre_id;
     media_library_controller_set_content_callback(p_view->p_sys->p_ctrl, audio_list_song_get_genre_songs_cb, p_view->p_sys);
+    // The media items don't carry their genre, new songs come from the content query
+    media_library_controller_set_filter(p_view->p_sys->p_ctrl, NULL, NULL);
     media_library_controller_refresh(p_view->p_sys->p_ctrl);
     return p_view;
 }
 
-
+list_view*
+audio_list_song_view_search_create(interface* p_intf, Evas_Object* p_parent, list_view_create_option opts )
+{
+    list_view* p_view = audio_list_song_view_create(p_intf, p_parent, opts);
+    // Nothing to list until a pattern is set
+    media_library_controller_set_content_callback(p_view->p_sys->p_ctrl, audio_list_song_get_search_songs_cb, p_view->p_sys);
+    // Only the songs the search returned belong to the list
+    media_library_controller_set_filter(p_view->p_sys->p_ctrl, NULL, NULL);
+    return p_view;
+}
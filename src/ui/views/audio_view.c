@@ -169,8 +169,27 @@ audio_view_refresh_cb(void *data, Evas_Object *obj, void *event_info)
     p_sys->p_overflow_menu = NULL;
 }
 
+static void
+audio_view_search_cb(void *data, Evas_Object *obj, void *event_info)
+{
+    view_sys *p_sys = data;
+
+    list_view* p_view = audio_list_song_view_search_create(p_sys->p_intf, p_sys->nf_toolbar, LIST_CREATE_ALL);
+    if (p_view != NULL)
+    {
+        Evas_Object* p_panel = list_view_search_panel_add(p_view, p_sys->nf_toolbar);
+        Elm_Object_Item *it = elm_naviframe_item_push(p_sys->nf_toolbar, "", NULL, NULL, p_panel, NULL);
+        elm_naviframe_item_title_enabled_set(it, EINA_FALSE, EINA_FALSE);
+    }
+
+    /* */
+    evas_object_del(obj);
+    p_sys->p_overflow_menu = NULL;
+}
+
 static popup_menu audio_view_popup_menu[] =
 {
+        {"Search", NULL, audio_view_search_cb},
         {"Refresh", NULL, audio_view_refresh_cb},
         {0}
 };
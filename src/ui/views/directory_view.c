@@ -78,25 +78,24 @@ free_list_item_data(void *data, Evas_Object *obj, void *event_info)
     free(dd);
 }
 
-static int compare_sort_items(const void *data1, const void *data2)
+static const char*
+directory_data_name(const directory_data *dd)
 {
-	const char *label1, *label2;
-	const Elm_Object_Item *li_it1 = data1;
-	const Elm_Object_Item *li_it2 = data2;
-	const directory_data *li_data1, *li_data2;
-
-	label1 = elm_object_item_text_get(li_it1);
-	label2 = elm_object_item_text_get(li_it2);
+    const char *psz_name = strrchr(dd->file_path, '/');
+    return psz_name != NULL ? psz_name + 1 : dd->file_path;
+}
 
-	li_data1 = elm_object_item_data_get(data1);
-	li_data2 = elm_object_item_data_get(data2);
+static int compare_sort_items(const void *data1, const void *data2)
+{
+	const directory_data *li_data1 = data1;
+	const directory_data *li_data2 = data2;
 
 	if (!li_data1->is_file && li_data2->is_file)
 		return -1;
 	else if (li_data1->is_file && !li_data2->is_file)
 		return 1;
 
-	return strcasecmp(label1, label2);
+	return strcasecmp(directory_data_name(li_data1), directory_data_name(li_data2));
 }
 
 bool
@@ -222,6 +221,7 @@ browse_directory(view_sys *dv, const char* path)
     Elm_Object_Item *item;
     Evas_Object *file_list;
     directory_data *dd;
+    Eina_List *entries = NULL;
     DIR* rep = NULL;
     struct dirent* current_folder = NULL;
     struct stat st;
@@ -309,14 +309,20 @@ browse_directory(view_sys *dv, const char* path)
         dd->dv = dv;
         dd->is_file = is_file;
         dd->file_path = file_path;
+        entries = eina_list_append(entries, dd);
+    }
+    closedir(rep);
 
+    /* Sort all the entries at once, instead of doing a sorted insertion for each of them */
+    entries = eina_list_sort(entries, 0, compare_sort_items);
+    EINA_LIST_FREE(entries, dd)
+    {
         /* Set and append new item in the list */
-        item = elm_list_item_sorted_insert(file_list, current_folder->d_name, NULL, NULL, list_selected_cb, dd, compare_sort_items);
+        item = elm_list_item_append(file_list, directory_data_name(dd), NULL, NULL, list_selected_cb, dd);
 
         /* */
         elm_object_item_del_cb_set(item, free_list_item_data);
     }
-    closedir(rep);
 
     /* */
     elm_list_go(file_list);
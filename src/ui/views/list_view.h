@@ -54,9 +54,17 @@ audio_list_song_view_album_create(interface* p_intf, Evas_Object* p_parent, unsi
 list_view*
 audio_list_song_view_genre_create(interface* p_intf, Evas_Object* p_parent, unsigned int i_genre_id, list_view_create_option opts );
 
+// Creates a view that lists the songs matching a search pattern
+list_view*
+audio_list_song_view_search_create(interface* p_intf, Evas_Object* p_parent, list_view_create_option opts );
+
 list_view*
 video_view_list_create(interface *intf, Evas_Object *p_parent, list_view_create_option opts );
 
+// Creates a view that lists the videos matching a search pattern
+list_view*
+video_view_list_search_create(interface *intf, Evas_Object *p_parent, list_view_create_option opts );
+
 list_view*
 audio_list_genres_view_create(interface* p_intf, Evas_Object* p_parent, list_view_create_option opts);
 
@@ -66,4 +74,14 @@ audio_list_genres_view_create(interface* p_intf, Evas_Object* p_parent, list_vie
 list_view*
 audio_list_album_view_create(interface* p_intf, Evas_Object* p_parent, unsigned int i_artist_, list_view_create_option opts);
 
+// Sets the pattern of a search view. Its content is refreshed once the
+// pattern stops changing
+void
+list_view_set_search_pattern(list_view* p_view, const char* psz_pattern);
+
+// Wraps a search view in a box, below a search entry.
+// The view is destroyed along with the returned object.
+Evas_Object*
+list_view_search_panel_add(list_view* p_view, Evas_Object* p_parent);
+
 #endif // LIST_VIEW_H_
@@ -28,6 +28,13 @@
 
 #include "list_view_private.h"
 #include "controller/media_library_controller.h"
+#include "media/library/library_item.h"
+#include "ui/thumbnailer.h"
+
+/* Maximum number of rows to prefetch the thumbnails of */
+#define LIST_VIEW_MAX_PREFETCH 16
+/* Time without typing after which a search is started, in seconds */
+#define LIST_VIEW_SEARCH_DELAY 0.3
 
 struct list_sys
 {
@@ -45,7 +52,9 @@ static void
 list_view_destroy(list_sys* p_list_sys)
 {
     media_library_controller_destroy(p_list_sys->p_ctrl);
+    list_view_common_cleanup(p_list_sys);
     elm_genlist_item_class_free(p_list_sys->p_default_item_class);
+    free(p_list_sys->psz_search_pattern);
     free(p_list_sys);
 }
 
@@ -71,6 +80,159 @@ list_view_toggle_empty(list_sys* p_list_sys, bool b_empty)
     evas_object_hide(p_hide);
 }
 
+Elm_Object_Item*
+list_view_insert_object_item(list_sys* p_list_sys, const Elm_Genlist_Item_Class* p_itc, const void* p_data,
+        Elm_Object_Item* p_before, Evas_Smart_Cb pf_selected, const void* p_selected_data)
+{
+    if (p_before == NULL)
+        return elm_genlist_item_append(p_list_sys->p_list, p_itc, p_data, NULL,
+                ELM_GENLIST_ITEM_NONE, pf_selected, p_selected_data);
+    return elm_genlist_item_insert_before(p_list_sys->p_list, p_itc, p_data, NULL, p_before,
+            ELM_GENLIST_ITEM_NONE, pf_selected, p_selected_data);
+}
+
+void
+list_view_remove_object_item(list_sys* p_list_sys, Elm_Object_Item* p_object_item)
+{
+    elm_object_item_del(p_object_item);
+    if (elm_genlist_items_count(p_list_sys->p_list) == 0)
+        list_view_toggle_empty(p_list_sys, true);
+}
+
+/* Prefetches the thumbnails of the rows about to be realized, in the scroll
+ * direction. As many rows as the genlist currently has realized, so roughly a
+ * screen, are prefetched */
+static void
+list_view_realized_cb(void *data, Evas_Object *obj, void *event_info)
+{
+    list_view* p_view = data;
+    list_sys* p_list_sys = p_view->p_sys;
+    Elm_Object_Item *it = event_info;
+    int i_index = elm_genlist_item_index_get(it);
+    bool b_forward = i_index >= p_list_sys->i_last_realized;
+
+    p_list_sys->i_last_realized = i_index;
+    p_list_sys->i_nb_realized++;
+
+    thumbnailer* p_thumbnailer = intf_get_thumbnailer(p_list_sys->p_intf);
+    unsigned int i_nb_prefetch = p_list_sys->i_nb_realized;
+    if (i_nb_prefetch > LIST_VIEW_MAX_PREFETCH)
+        i_nb_prefetch = LIST_VIEW_MAX_PREFETCH;
+    for (unsigned int i = 0; i < i_nb_prefetch; ++i)
+    {
+        it = b_forward ? elm_genlist_item_next_get(it) : elm_genlist_item_prev_get(it);
+        if (it == NULL)
+            break;
+        list_view_item* p_view_item = elm_object_item_data_get(it);
+        if (p_view_item == NULL)
+            continue;
+        const char* psz_artwork = library_item_get_artwork(p_view->pf_get_item(p_view_item));
+        if (psz_artwork != NULL)
+            thumbnailer_prefetch(p_thumbnailer, psz_artwork);
+    }
+}
+
+static void
+list_view_unrealized_cb(void *data, Evas_Object *obj, void *event_info)
+{
+    list_view* p_view = data;
+    if (p_view->p_sys->i_nb_realized > 0)
+        p_view->p_sys->i_nb_realized--;
+}
+
+void
+list_view_common_cleanup(list_sys* p_list_sys)
+{
+    if (p_list_sys->p_list == NULL)
+        return;
+    evas_object_smart_callback_del(p_list_sys->p_list, "realized", list_view_realized_cb);
+    evas_object_smart_callback_del(p_list_sys->p_list, "unrealized", list_view_unrealized_cb);
+}
+
+void
+list_view_set_search_pattern(list_view* p_view, const char* psz_pattern)
+{
+    list_sys* p_list_sys = p_view->p_sys;
+    free(p_list_sys->psz_search_pattern);
+    p_list_sys->psz_search_pattern = psz_pattern != NULL ? strdup(psz_pattern) : NULL;
+    /* A search for the previous pattern keeps running until the delay
+     * expires, the new one then replaces it */
+    media_library_controller_refresh_delayed(p_list_sys->p_ctrl, LIST_VIEW_SEARCH_DELAY);
+}
+
+static void
+list_view_search_changed_cb(void *data, Evas_Object *obj, void *event_info)
+{
+    list_view* p_view = data;
+    char* psz_pattern = elm_entry_markup_to_utf8(elm_entry_entry_get(obj));
+    list_view_set_search_pattern(p_view, psz_pattern);
+    free(psz_pattern);
+}
+
+static void
+list_view_search_panel_del_cb(void *data, Evas *e, Evas_Object *obj, void *event_info)
+{
+    list_view* p_view = data;
+    p_view->pf_del(p_view->p_sys);
+    free(p_view);
+}
+
+Evas_Object*
+list_view_search_panel_add(list_view* p_view, Evas_Object* p_parent)
+{
+    Evas_Object* p_box = elm_box_add(p_parent);
+    evas_object_size_hint_weight_set(p_box, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+    evas_object_size_hint_align_set(p_box, EVAS_HINT_FILL, EVAS_HINT_FILL);
+
+    /* Search entry */
+    Evas_Object* p_entry = elm_entry_add(p_box);
+    elm_entry_single_line_set(p_entry, EINA_TRUE);
+    elm_entry_scrollable_set(p_entry, EINA_TRUE);
+    elm_object_part_text_set(p_entry, "elm.guide", "Search");
+    evas_object_size_hint_weight_set(p_entry, EVAS_HINT_EXPAND, 0.0);
+    evas_object_size_hint_align_set(p_entry, EVAS_HINT_FILL, 0.0);
+    evas_object_smart_callback_add(p_entry, "changed,user", list_view_search_changed_cb, p_view);
+    elm_box_pack_end(p_box, p_entry);
+    evas_object_show(p_entry);
+
+    /* Results */
+    Evas_Object* p_list = p_view->pf_get_widget(p_view->p_sys);
+    elm_box_pack_end(p_box, p_list);
+    evas_object_show(p_list);
+
+    evas_object_event_callback_add(p_box, EVAS_CALLBACK_DEL, list_view_search_panel_del_cb, p_view);
+    elm_object_focus_set(p_entry, EINA_TRUE);
+    evas_object_show(p_box);
+    return p_box;
+}
+
+void
+list_view_labels_clear(list_view_labels* p_labels)
+{
+    free(p_labels->psz_main);
+    free(p_labels->psz_sub_left);
+    free(p_labels->psz_sub_right);
+    memset(p_labels, 0, sizeof(*p_labels));
+}
+
+char*
+list_view_labels_get(const list_view_labels* p_labels, const char* psz_part)
+{
+    const char* psz_label = NULL;
+    /* All the parts start with "elm.text." */
+    if (psz_part == NULL || strncmp(psz_part, "elm.text.", 9) != 0)
+        return NULL;
+    psz_part += 9;
+    if (strcmp(psz_part, "main.left.top") == 0)
+        psz_label = p_labels->psz_main;
+    else if (strcmp(psz_part, "sub.left.bottom") == 0)
+        psz_label = p_labels->psz_sub_left;
+    else if (strcmp(psz_part, "sub.right.bottom") == 0)
+        psz_label = p_labels->psz_sub_right;
+    /* genlist frees the labels it is given, so they can't be shared */
+    return psz_label != NULL ? strdup(psz_label) : NULL;
+}
+
 void
 list_view_common_setup(list_view* p_list_view, list_sys* p_list_sys, interface* p_intf, Evas_Object* p_parent, list_view_create_option opts )
 {
@@ -111,6 +273,9 @@ list_view_common_setup(list_view* p_list_view, list_sys* p_list_sys, interface*
         /* Item Class */
         p_list_sys->p_default_item_class = elm_genlist_item_class_new();
         p_list_sys->p_default_item_class->item_style = "2line.top.3";
+
+        evas_object_smart_callback_add(p_list_sys->p_list, "realized", list_view_realized_cb, p_list_view);
+        evas_object_smart_callback_add(p_list_sys->p_list, "unrealized", list_view_unrealized_cb, p_list_view);
     }
 
     /* Setup common callbacks */
@@ -39,12 +39,47 @@
     Evas_Object*                p_container;            \
     Evas_Object*                p_box;                  \
     Evas_Object*                p_empty_label;          \
-    bool                        b_empty;
+    char*                       psz_search_pattern;     \
+    bool                        b_empty;                \
+    int                         i_last_realized;        \
+    unsigned int                i_nb_realized;
+
+/*
+ * Formatted labels of a row, computed when its item is set rather than each
+ * time genlist realizes the row.
+ */
+typedef struct list_view_labels
+{
+    char* psz_main;         /* elm.text.main.left.top */
+    char* psz_sub_left;     /* elm.text.sub.left.bottom */
+    char* psz_sub_right;    /* elm.text.sub.right.bottom */
+} list_view_labels;
+
+void
+list_view_labels_clear(list_view_labels* p_labels);
+
+/* Returns a copy of the label of psz_part, for genlist to free */
+char*
+list_view_labels_get(const list_view_labels* p_labels, const char* psz_part);
 
 void
 list_view_common_setup(list_view* p_view, list_sys* p_list, interface* p_intf, Evas_Object* p_parent, list_view_create_option opts);
 
+/* Unregisters the callbacks set by list_view_common_setup, the genlist can
+ * outlive the view */
+void
+list_view_common_cleanup(list_sys* p_list_sys);
+
 void
 list_view_toggle_empty(list_sys* p_view, bool b_empty);
 
+/* Appends a genlist item, or inserts it before p_before if it isn't NULL */
+Elm_Object_Item*
+list_view_insert_object_item(list_sys* p_view, const Elm_Genlist_Item_Class* p_itc, const void* p_data,
+        Elm_Object_Item* p_before, Evas_Smart_Cb pf_selected, const void* p_selected_data);
+
+/* Deletes a genlist item, and toggles the empty label when it was the last one */
+void
+list_view_remove_object_item(list_sys* p_view, Elm_Object_Item* p_object_item);
+
 #endif // LIST_VIEW_PRIVATE_H_
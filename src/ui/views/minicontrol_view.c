@@ -28,9 +28,11 @@
 #include "minicontrol_view.h"
 #include "playback_service.h"
 #include "ui/utils.h"
+#include "media/artwork.h"
 
 #include <minicontrol-provider.h>
 #include <sys/time.h>
+#include <limits.h>
 
 struct minicontrol
 {
@@ -78,7 +80,11 @@ mini_control_cover_set(minicontrol *mc, const char* path)
     if (!path)
         elm_object_part_content_set(mc->layout, "swallow.cover", create_icon(mc->layout, "background_cone.png"));
     else
-        elm_object_part_content_set(mc->layout, "swallow.cover", create_image(mc->layout, path));
+    {
+        char psz_buf[PATH_MAX];
+        elm_object_part_content_set(mc->layout, "swallow.cover", create_image(mc->layout,
+                artwork_variant_path(path, ARTWORK_COVER, psz_buf, sizeof(psz_buf))));
+    }
 }
 
 long
@@ -32,6 +32,7 @@
 #include "list_view_private.h"
 #include "media/media_item.h"
 #include "ui/interface.h"
+#include "ui/thumbnailer.h"
 #include "ui/utils.h"
 #include "video_player.h"
 
@@ -44,6 +45,7 @@ struct list_view_item
 
     //For refresh purposes.
     Elm_Object_Item*                p_object_item;
+    list_view_labels                labels;
 };
 
 struct list_sys
@@ -64,38 +66,30 @@ free_list_item(void *data, Evas_Object *obj, void *event_info)
 {
     list_view_item *p_view_item = data;
     media_item_destroy(p_view_item->p_media_item);
+    list_view_labels_clear(&p_view_item->labels);
     free(p_view_item);
 }
 
+static void
+video_list_item_update_labels(list_view_item* p_view_item)
+{
+    const media_item *p_mi = p_view_item->p_media_item;
+
+    list_view_labels_clear(&p_view_item->labels);
+    if (asprintf(&p_view_item->labels.psz_main, "<b>%s</b>", media_item_title(p_mi)) < 0)
+        p_view_item->labels.psz_main = NULL;
+    if (p_mi->i_duration >= 0)
+        p_view_item->labels.psz_sub_left = media_timetostr(p_mi->i_duration / 1000);
+    if (p_mi->i_w > 0 && p_mi->i_h > 0 &&
+            asprintf(&p_view_item->labels.psz_sub_right, "%dx%d", p_mi->i_w, p_mi->i_h) < 0)
+        p_view_item->labels.psz_sub_right = NULL;
+}
+
 static char *
 genlist_text_get_cb(void *data, Evas_Object *obj, const char *part)
 {
     list_view_item *p_view_item = data;
-    const Elm_Genlist_Item_Class *itc = p_view_item->itc;
-
-    /* Check the item class style and put the current folder or file name as a string */
-    /* Then put this string as the genlist item label */
-    if (itc->item_style && !strcmp(itc->item_style, "2line.top.3")) {
-        if (part && !strcmp(part, "elm.text.main.left.top")) {
-            char *buff;
-            asprintf(&buff, "<b>%s</b>", media_item_title(p_view_item->p_media_item));
-            return buff;
-        }
-        else if (!strcmp(part, "elm.text.sub.left.bottom")) {
-            if(p_view_item->p_media_item->i_duration < 0)
-                return NULL;
-            else
-                return media_timetostr(p_view_item->p_media_item->i_duration/1000);
-        }
-        else if (!strcmp(part, "elm.text.sub.right.bottom")) {
-            if (p_view_item->p_media_item->i_w <= 0 || p_view_item->p_media_item->i_h <= 0)
-                return NULL;
-            char *str_resolution;
-            asprintf( &str_resolution, "%dx%d", p_view_item->p_media_item->i_w, p_view_item->p_media_item->i_h);
-            return str_resolution;
-        }
-    }
-    return NULL;
+    return list_view_labels_get(&p_view_item->labels, part);
 }
 
 static const void*
@@ -108,10 +102,18 @@ static void
 video_list_item_set_media_item(list_view_item* p_view_item, void* p_data)
 {
     media_item* p_media_item = (media_item*)p_data;
+    media_item_destroy(p_view_item->p_media_item);
     p_view_item->p_media_item = p_media_item;
+    video_list_item_update_labels(p_view_item);
     ecore_main_loop_thread_safe_call_async((Ecore_Cb)elm_genlist_item_update, p_view_item->p_object_item);
 }
 
+static void
+video_list_item_remove(list_sys* p_list_sys, list_view_item* p_view_item)
+{
+    list_view_remove_object_item(p_list_sys, p_view_item->p_object_item);
+}
+
 static Evas_Object*
 genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
 {
@@ -126,12 +128,8 @@ genlist_content_get_cb(void *data, Evas_Object *obj, const char *part)
         if (part && !strcmp(part, "elm.icon.1")) {
             layout = elm_layout_add(obj);
             elm_layout_theme_set(layout, "layout", "list/B/type.1", "default");
-            Evas_Object *icon;
-            if (p_view_item->p_media_item->psz_snapshot != NULL)
-                icon = create_image(layout, p_view_item->p_media_item->psz_snapshot);
-            else
-                icon = create_icon(layout, "background_cone.png");
-            elm_layout_content_set(layout, "elm.swallow.content", icon);
+            thumbnailer_content_set(intf_get_thumbnailer(p_view_item->p_list_sys->p_intf), layout, "elm.swallow.content",
+                    p_view_item->p_media_item->psz_snapshot, "background_cone.png");
         }
     }
 
@@ -144,12 +142,6 @@ genlist_loaded_cb(void *data EINA_UNUSED, Evas_Object *obj, void *event_info EIN
     /* Set the callbacks when one of the genlist item is loaded */
 }
 
-static void
-genlist_realized_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
-{
-    /* Set the callbacks when one of the genlist item is realized */
-}
-
 static void
 genlist_longpressed_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void *event_info)
 {
@@ -166,7 +158,7 @@ genlist_contracted_cb(void *data EINA_UNUSED, Evas_Object *obj EINA_UNUSED, void
 }
 
 static list_view_item*
-video_view_append_item(list_sys *p_list_sys, void* p_data)
+video_view_insert_item(list_sys *p_list_sys, void* p_data, list_view_item* p_before)
 {
     media_item* p_item = (media_item*)p_data;
     /* */
@@ -179,12 +171,12 @@ video_view_append_item(list_sys *p_list_sys, void* p_data)
 
     /* Item instantiation */
     vli->p_media_item = p_item;
-    /* Set and append new item in the genlist */
-    vli->p_object_item = elm_genlist_item_append(p_list_sys->p_list,
+    video_list_item_update_labels(vli);
+    /* Set and insert the new item in the genlist */
+    vli->p_object_item = list_view_insert_object_item(p_list_sys,
             vli->itc,                       /* genlist item class               */
             vli,                            /* genlist item class user data     */
-            NULL,                           /* genlist parent item for trees    */
-            ELM_GENLIST_ITEM_NONE,          /* genlist item type                */
+            p_before != NULL ? p_before->p_object_item : NULL,
             genlist_item_selected_cb,       /* genlist select smart callback    */
             vli);                           /* genlist smart callback user data */
     if (vli->p_object_item == NULL)
@@ -198,8 +190,23 @@ video_view_append_item(list_sys *p_list_sys, void* p_data)
     return vli;
 }
 
-list_view*
-video_view_list_create(interface *p_intf, Evas_Object *p_parent, list_view_create_option opts)
+static list_view_item*
+video_view_append_item(list_sys *p_list_sys, void* p_data)
+{
+    return video_view_insert_item(p_list_sys, p_data, NULL);
+}
+
+static media_library_query*
+video_list_get_search_videos_cb(media_library* p_ml, const media_library_sort* p_sort, media_library_query_priority i_priority, media_library_list_cb cb, void* p_user_data)
+{
+    list_sys* p_list_sys = (list_sys*)p_user_data;
+    if (p_list_sys->psz_search_pattern == NULL || *p_list_sys->psz_search_pattern == 0)
+        return NULL;
+    return media_library_search(p_ml, p_list_sys->psz_search_pattern, MEDIA_ITEM_TYPE_VIDEO, i_priority, cb, p_list_sys->p_ctrl);
+}
+
+static list_view*
+video_view_list_setup(interface *p_intf, Evas_Object *p_parent, list_view_create_option opts)
 {
     list_view* p_list_view = calloc(1, sizeof(*p_list_view));
     if (p_list_view == NULL)
@@ -220,18 +227,42 @@ video_view_list_create(interface *p_intf, Evas_Object *p_parent, list_view_creat
     evas_object_size_hint_align_set(p_list_sys->p_list, EVAS_HINT_FILL, EVAS_HINT_FILL);
 
     /* Set smart Callbacks on the list */
-    evas_object_smart_callback_add(p_list_sys->p_list, "realized", genlist_realized_cb, NULL);
     evas_object_smart_callback_add(p_list_sys->p_list, "loaded", genlist_loaded_cb, NULL);
     evas_object_smart_callback_add(p_list_sys->p_list, "longpressed", genlist_longpressed_cb, NULL);
     evas_object_smart_callback_add(p_list_sys->p_list, "contracted", genlist_contracted_cb, NULL);
 
     p_list_view->pf_append_item = &video_view_append_item;
+    p_list_view->pf_insert_item = &video_view_insert_item;
     p_list_view->pf_get_item = &video_list_item_get_media_item;
     p_list_view->pf_set_item = &video_list_item_set_media_item;
+    p_list_view->pf_remove_item = &video_list_item_remove;
 
     p_list_sys->p_ctrl = video_controller_create(intf_get_application(p_intf), p_list_view);
-    media_library_controller_refresh(p_list_sys->p_ctrl);
 
     return p_list_view;
 }
 
+list_view*
+video_view_list_create(interface *p_intf, Evas_Object *p_parent, list_view_create_option opts)
+{
+    list_view* p_list_view = video_view_list_setup(p_intf, p_parent, opts);
+    if (p_list_view == NULL)
+        return NULL;
+    media_library_controller_set_snapshot(p_list_view->p_sys->p_ctrl, "videos");
+    media_library_controller_refresh(p_list_view->p_sys->p_ctrl);
+    return p_list_view;
+}
+
+list_view*
+video_view_list_search_create(interface *p_intf, Evas_Object *p_parent, list_view_create_option opts)
+{
+    list_view* p_list_view = video_view_list_setup(p_intf, p_parent, opts);
+    if (p_list_view == NULL)
+        return NULL;
+    // Nothing to list until a pattern is set
+    media_library_controller_set_content_callback(p_list_view->p_sys->p_ctrl, video_list_get_search_videos_cb, p_list_view->p_sys);
+    // Only the videos the search returned belong to the list
+    media_library_controller_set_filter(p_list_view->p_sys->p_ctrl, NULL, NULL);
+    return p_list_view;
+}
+
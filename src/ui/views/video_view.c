@@ -31,6 +31,7 @@
 #include "video_view.h"
 #include "list_view.h"
 #include "ui/menu/popup_menu.h"
+#include "ui/utils.h"
 #include "media/library/media_library.hpp"
 
 struct view_sys
@@ -38,6 +39,7 @@ struct view_sys
     interface* p_intf;
     Evas_Object *p_parent;
     Evas_Object *p_overflow_menu;
+    Evas_Object *p_naviframe;
     list_view* p_list;
 };
 
@@ -59,6 +61,24 @@ video_view_refresh_cb(void *data, Evas_Object *obj, void *event_info)
     p_sys->p_overflow_menu = NULL;
 }
 
+static void
+video_view_search_cb(void *data, Evas_Object *obj, void *event_info)
+{
+    view_sys *p_sys = data;
+
+    list_view* p_view = video_view_list_search_create(p_sys->p_intf, p_sys->p_naviframe, LIST_CREATE_ALL);
+    if (p_view != NULL)
+    {
+        Evas_Object* p_panel = list_view_search_panel_add(p_view, p_sys->p_naviframe);
+        Elm_Object_Item *it = elm_naviframe_item_push(p_sys->p_naviframe, "", NULL, NULL, p_panel, NULL);
+        elm_naviframe_item_title_enabled_set(it, EINA_FALSE, EINA_FALSE);
+    }
+
+    /* */
+    evas_object_del(obj);
+    p_sys->p_overflow_menu = NULL;
+}
+
 static void
 video_view_popup_close_cb(void *data, Evas_Object *obj, void *event_info)
 {
@@ -69,6 +89,7 @@ video_view_popup_close_cb(void *data, Evas_Object *obj, void *event_info)
 
 static popup_menu video_view_popup_menu[] =
 {
+    {"Search", NULL, video_view_search_cb},
     {"Refresh", NULL, video_view_refresh_cb},
     {0}
 };
@@ -98,6 +119,11 @@ video_view_callback(view_sys *p_view_sys, interface_view_event event)
             p_view_sys->p_overflow_menu = NULL;
             return true;
         }
+        if (naviframe_count(p_view_sys->p_naviframe) > 1)
+        {
+            elm_naviframe_item_pop(p_view_sys->p_naviframe);
+            return true;
+        }
         return false;
     default:
         break;
@@ -125,9 +151,19 @@ create_video_view(interface *intf, Evas_Object *parent)
     view->pf_event = video_view_callback;
     view->pf_has_menu = video_view_has_menu;
 
-    p_sys->p_list = video_view_list_create(intf, parent, LIST_CREATE_ALL);
+    /* Search results are pushed on top of the video list */
+    p_sys->p_naviframe = elm_naviframe_add(parent);
+    evas_object_size_hint_weight_set(p_sys->p_naviframe, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+    evas_object_size_hint_align_set(p_sys->p_naviframe, EVAS_HINT_FILL, EVAS_HINT_FILL);
+    evas_object_show(p_sys->p_naviframe);
+
+    p_sys->p_list = video_view_list_create(intf, p_sys->p_naviframe, LIST_CREATE_ALL);
+
+    Evas_Object* p_list = p_sys->p_list->pf_get_widget(p_sys->p_list->p_sys);
+    Elm_Object_Item *it = elm_naviframe_item_push(p_sys->p_naviframe, "", NULL, NULL, p_list, NULL);
+    elm_naviframe_item_title_enabled_set(it, EINA_FALSE, EINA_FALSE);
 
-    view->view = p_sys->p_list->pf_get_widget(p_sys->p_list->p_sys);
+    view->view = p_sys->p_naviframe;
 
     /* */
     return view;